@@ -0,0 +1,141 @@
+/**
+ * Microbenchmark of one generation step: the linear rule search that `iterate()` used
+ * to do, against the compiled rule table that it uses now. Every example in the
+ * example library is expanded to its listed number of iterations with both loops, and
+ * the outputs are compared before the timings are printed.
+ *
+ * Build from the repository root with:
+ *
+ *     cc -O2 -Iinclude $(python3-config --includes) bench/rule_table_bench.c $(find src -name '*.c') -o rule_table_bench $(python3-config --ldflags --embed) -lm -lpthread
+ */
+#include "parser.h"
+#include "length.h"
+#include "rule_table.h"
+#include "example_library.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define REPEATS 5 // best of this many runs is reported
+
+static const char* example_names[10] = {
+    "Fractal Tree", "Fractal Plant", "Bush 1", "Bush 2", "Bush 4",
+    "Board", "Sierpinski Arrowhead", "Pentaplexity", "Dragon Curve", "Hexagonal Gosper"
+};
+
+/**
+ * @brief Seconds elapsed on the monotonic clock.
+ */
+static double now() { // monotonic time in seconds
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief The previous generation step: a linear search of the rules and a strlen for every character.
+ */
+static void iterate_linear(const char* current_buffer, char* next_buffer, Rule rules[]) { // baseline loop
+    size_t current_buffer_len = strlen(current_buffer);
+    size_t next_buffer_length = 0;
+
+    for (size_t i = 0; i < current_buffer_len; i++) {
+        int matched = 0;
+
+        for (int j = 0; rules[j].character != '\0'; j++) {
+            if (current_buffer[i] == rules[j].character) {
+                size_t rule_length = strlen(rules[j].rule);
+                memcpy(next_buffer + next_buffer_length, rules[j].rule, rule_length);
+                next_buffer_length += rule_length;
+                matched = 1;
+                break;
+            }
+        }
+
+        if (!matched) {
+            next_buffer[next_buffer_length++] = current_buffer[i];
+        }
+    }
+
+    next_buffer[next_buffer_length] = '\0';
+}
+
+/**
+ * @brief Expands one example with either loop and returns the best time, leaving the result in `current`.
+ */
+static double run(L_System* sys, int compiled, char** current, char** next, size_t buffer_size) { // time one full expansion
+    double best = -1;
+
+    for (int repeat = 0; repeat < REPEATS; repeat++) {
+        double start = now();
+        RuleTable table;
+        size_t size = buffer_size;
+
+        if (compiled && !compile_rules(&table, sys->rules)) {
+            return -1;
+        }
+
+        strcpy(*current, sys->axiom);
+        for (int iteration = 0; iteration < sys->iterations; iteration++) {
+            if (compiled) {
+                iterate(*current, next, &size, &table);
+            } else {
+                iterate_linear(*current, *next, sys->rules);
+            }
+
+            char* temp = *current;
+            *current = *next;
+            *next = temp;
+        }
+
+        if (compiled) {
+            free_rule_table(&table);
+        }
+
+        double elapsed = now() - start;
+        if (best < 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    return best;
+}
+
+int main(void) {
+    printf("%-22s %12s %12s %12s %8s\n", "example", "length", "linear (ms)", "table (ms)", "speedup");
+
+    for (int i = 0; i < 10; i++) {
+        L_System sys = example_library[i];
+        size_t buffer_size, length;
+        if (!calculate_buffer_size(sys.axiom, sys.rules, sys.iterations, &buffer_size)
+            || !calculate_parsed_length(sys.axiom, sys.rules, sys.iterations, &length)) {
+            printf("%-22s failed to size buffers\n", example_names[i]);
+            continue;
+        }
+
+        char *current, *next, *linear_result;
+        if (!buffer_allocate(&current, &next, buffer_size) || !(linear_result = malloc(buffer_size))) {
+            printf("%-22s failed to allocate buffers\n", example_names[i]);
+            return 1;
+        }
+
+        double linear = run(&sys, 0, &current, &next, buffer_size);
+        strcpy(linear_result, current);
+        double table = run(&sys, 1, &current, &next, buffer_size);
+
+        if (strcmp(linear_result, current) != 0) {
+            printf("%-22s MISMATCH between loops\n", example_names[i]);
+        } else {
+            printf("%-22s %12zu %12.3f %12.3f %7.2fx\n", example_names[i], length,
+                linear * 1e3, table * 1e3, linear / table);
+        }
+
+        buffer_release(current);
+        buffer_release(next);
+        free(linear_result);
+    }
+
+    return 0;
+}
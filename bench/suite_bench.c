@@ -0,0 +1,435 @@
+/**
+ * Benchmark suite over the whole example library. Every example is run at each
+ * iteration count from 1 up to its listed count (plus `--extra`), and each run reports:
+ *
+ * - the wall time of its last generation step with `iterate()`, and its output bytes/sec
+ * - the wall time and bytes/sec of a full `parser()` expansion
+ * - the wall time and bytes/sec of a `parser_parallel()` expansion, on `--threads` threads
+ * - the bytes and wall time of a packed `parser_packed()` expansion
+ * - the reallocations `buffer_resize()` makes when the buffers are sized by the original
+ *   growth-factor estimate; the parsers themselves now size every buffer exactly and never
+ *   reallocate, so this is what that exact sizing saves
+ * - the peak RSS while running, in kB
+ * - the turtle segments and segments/sec when interpreting the expansion
+ *
+ * Results are written to stdout as CSV (the default) or, with `--format json`, as a JSON
+ * array, so runs can be stored and compared between releases. Runs whose parsed length
+ * would exceed `--max-bytes` are skipped. `--buffers mapped` runs the generation steps on
+ * the mapped buffer backend instead of the heap. `--threads N` sets the threads of the
+ * parallel expansion, one per CPU by default.
+ *
+ * Build from the repository root with:
+ *
+ *     cc -O2 -Iinclude $(python3-config --includes) bench/suite_bench.c $(find src -name '*.c') -o suite_bench $(python3-config --ldflags --embed) -lm -lpthread
+ */
+#include "parser.h"
+#include "parallel.h"
+#include "length.h"
+#include "rule_table.h"
+#include "stream.h"
+#include "turtle.h"
+#include "example_library.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <sys/resource.h>
+
+#define REPEATS 3 // best of this many runs is reported
+#define DEFAULT_MAX_BYTES ((size_t)1 << 30) // skip expansions longer than 1 GiB unless told otherwise
+
+static int parallel_threads = 0; // threads for parser_parallel(), 0 for one per CPU
+
+static const char* example_names[10] = {
+    "Fractal Tree", "Fractal Plant", "Bush 1", "Bush 2", "Bush 4",
+    "Board", "Sierpinski Arrowhead", "Pentaplexity", "Dragon Curve", "Hexagonal Gosper"
+};
+
+typedef struct {
+    int example;
+    int iterations;
+    size_t length;
+    double generation_seconds;
+    double expand_seconds;
+    double parallel_seconds;
+    size_t packed_bytes;
+    double packed_seconds;
+    size_t reallocs;
+    long peak_rss_kb;
+    size_t segments;
+    double turtle_seconds;
+} BenchRow; // one measured (example, iterations) pair
+
+/**
+ * @brief Seconds elapsed on the monotonic clock.
+ */
+static double now() { // monotonic time in seconds
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Resets the kernel's peak RSS mark to the current RSS, where supported.
+ */
+static void reset_peak_rss() { // start a new high-water mark
+    FILE* file = fopen("/proc/self/clear_refs", "w");
+    if (file) {
+        fputs("5", file);
+        fclose(file);
+    }
+}
+
+/**
+ * @brief Reads the peak RSS since the last reset, in kB.
+ *
+ * Uses VmHWM from /proc/self/status, falling back to getrusage(), which only ever grows.
+ */
+static long peak_rss_kb() { // high-water mark of resident memory
+    FILE* file = fopen("/proc/self/status", "r");
+    char line[256];
+    long peak = -1;
+
+    while (file && fgets(line, sizeof(line), file)) {
+        if (sscanf(line, "VmHWM: %ld kB", &peak) == 1) {
+            break;
+        }
+    }
+    if (file) {
+        fclose(file);
+    }
+
+    if (peak < 0) {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        peak = usage.ru_maxrss;
+    }
+
+    return peak;
+}
+
+/**
+ * @brief Turtle sink that only counts segments.
+ */
+static int count_segment(const float* segment, int continues, void* context) { // tally without storing
+    (void)segment;
+    (void)continues;
+    (*(size_t*)context)++;
+    return 1;
+}
+
+/**
+ * @brief Times the generation steps of one expansion, returning the best time of its last step.
+ */
+static double time_last_generation(L_System* sys, int iterations) { // breadth-first, like parser_breadth_first()
+    size_t buffer_size;
+    RuleTable table;
+    char *current, *next;
+    double best = -1;
+
+    if (!calculate_buffer_size(sys->axiom, sys->rules, iterations, &buffer_size) || !compile_rules(&table, sys->rules)) {
+        return -1;
+    }
+    if (!buffer_allocate(&current, &next, buffer_size)) {
+        free_rule_table(&table);
+        return -1;
+    }
+
+    for (int repeat = 0; repeat < REPEATS; repeat++) {
+        strcpy(current, sys->axiom);
+
+        for (int iteration = 0; iteration < iterations; iteration++) {
+            double start = now();
+            if (!iterate(current, &next, &buffer_size, &table)) {
+                best = -1;
+                repeat = REPEATS;
+                break;
+            }
+            double elapsed = now() - start;
+
+            if (iteration == iterations - 1 && (best < 0 || elapsed < best)) {
+                best = elapsed;
+            }
+
+            char* temp = current;
+            current = next;
+            next = temp;
+            buffer_discard(next);
+        }
+    }
+
+    buffer_release(current);
+    buffer_release(next);
+    free_rule_table(&table);
+
+    return best;
+}
+
+/**
+ * @brief Counts the reallocations of an expansion whose buffers are sized the original way.
+ *
+ * Both buffers start at the estimate the parser used before exact lengths: the axiom
+ * length times the average rule length (at least 1.5) to the power of the iterations,
+ * capped at 1,000,000 bytes and at least 10 times the axiom. `iterate()` then grows the
+ * next buffer with `buffer_resize()` whenever a generation outgrows it.
+ *
+ * @return The number of reallocations, or (size_t)-1 if allocation fails.
+ */
+static size_t count_estimated_reallocs(L_System* sys, int iterations) { // growth-factor sizing, as before exact lengths
+    double growth_factor = 0;
+    int rule_count = 0;
+    RuleTable table;
+    char *current, *next;
+
+    for (; rule_count < SIZE && sys->rules[rule_count].character != '\0'; rule_count++) {
+        growth_factor += strlen(sys->rules[rule_count].rule);
+    }
+    growth_factor = rule_count > 0 ? growth_factor / rule_count : 1.5;
+    if (growth_factor < 1.5) {
+        growth_factor = 1.5;
+    }
+
+    size_t axiom_length = strlen(sys->axiom);
+    double estimate = axiom_length * pow(growth_factor, iterations) + 1;
+    size_t current_size = estimate > 1000000 ? 1000000 : (size_t)estimate;
+    if (current_size < axiom_length * 10) {
+        current_size = axiom_length * 10;
+    }
+    size_t next_size = current_size;
+
+    if (!compile_rules(&table, sys->rules)) {
+        return (size_t)-1;
+    }
+    current = malloc(current_size);
+    next = malloc(next_size);
+    if (!current || !next) {
+        free(current);
+        free(next);
+        free_rule_table(&table);
+        return (size_t)-1;
+    }
+
+    size_t reallocs = buffer_resize_count;
+    int ok = 1;
+    strcpy(current, sys->axiom);
+
+    for (int iteration = 0; iteration < iterations && ok; iteration++) {
+        ok = iterate(current, &next, &next_size, &table);
+
+        char* temp = current;
+        current = next;
+        next = temp;
+        size_t temp_size = current_size;
+        current_size = next_size;
+        next_size = temp_size; // each buffer keeps the size it grew to
+    }
+    reallocs = buffer_resize_count - reallocs;
+
+    free(current);
+    free(next);
+    free_rule_table(&table);
+
+    return ok ? reallocs : (size_t)-1;
+}
+
+/**
+ * @brief Measures one (example, iterations) pair.
+ *
+ * @return 1 on success, 0 if any stage fails.
+ */
+static int measure(int example, int iterations, BenchRow* row) { // every metric for one run
+    L_System sys = example_library[example];
+    row->example = example;
+    row->iterations = iterations;
+
+    reset_peak_rss();
+
+    row->generation_seconds = iterations > 0 ? time_last_generation(&sys, iterations) : 0;
+    if (row->generation_seconds < 0) {
+        return 0;
+    }
+
+    row->expand_seconds = -1;
+    for (int repeat = 0; repeat < REPEATS; repeat++) {
+        double start = now();
+        char* parsed = parser(sys.axiom, sys.rules, iterations);
+        double elapsed = now() - start;
+
+        if (!parsed) {
+            return 0;
+        }
+        free(parsed);
+
+        if (row->expand_seconds < 0 || elapsed < row->expand_seconds) {
+            row->expand_seconds = elapsed;
+        }
+    }
+
+    row->reallocs = count_estimated_reallocs(&sys, iterations);
+    if (row->reallocs == (size_t)-1) {
+        return 0;
+    }
+
+    row->parallel_seconds = -1;
+    for (int repeat = 0; repeat < REPEATS; repeat++) {
+        double start = now();
+        char* parsed = parser_parallel(sys.axiom, sys.rules, iterations, parallel_threads);
+        double elapsed = now() - start;
+
+        if (!parsed) {
+            return 0;
+        }
+        buffer_release(parsed);
+
+        if (row->parallel_seconds < 0 || elapsed < row->parallel_seconds) {
+            row->parallel_seconds = elapsed;
+        }
+    }
+
+    row->packed_seconds = -1;
+    for (int repeat = 0; repeat < REPEATS; repeat++) {
+        PackedString packed;
+        double start = now();
+        if (!parser_packed(sys.axiom, sys.rules, iterations, &packed)) {
+            return 0;
+        }
+        double elapsed = now() - start;
+
+        row->packed_bytes = packed.alphabet.bits == 4 ? (packed.length + 1) / 2 : packed.length;
+        packed_string_free(&packed);
+
+        if (row->packed_seconds < 0 || elapsed < row->packed_seconds) {
+            row->packed_seconds = elapsed;
+        }
+    }
+
+    row->turtle_seconds = -1;
+    for (int repeat = 0; repeat < REPEATS; repeat++) {
+        Turtle turtle;
+        LStream stream;
+        size_t segments = 0;
+
+        turtle_init(&turtle, sys.turn_angle, sys.start_direction);
+        turtle.sink = count_segment;
+        turtle.sink_context = &segments;
+
+        double start = now();
+        if (!stream_init(&stream, sys.axiom, sys.rules, iterations)) {
+            return 0;
+        }
+        int ok = stream_drain(&stream, turtle_consume, &turtle) && turtle_finish(&turtle);
+        double elapsed = now() - start;
+
+        stream_free(&stream);
+        turtle_free(&turtle);
+        if (!ok) {
+            return 0;
+        }
+
+        row->segments = segments;
+        if (row->turtle_seconds < 0 || elapsed < row->turtle_seconds) {
+            row->turtle_seconds = elapsed;
+        }
+    }
+
+    row->peak_rss_kb = peak_rss_kb();
+    return 1;
+}
+
+/**
+ * @brief Divides a count by a time, reporting 0 for runs too fast to time.
+ */
+static double rate(double count, double seconds) { // per-second throughput
+    return seconds > 0 ? count / seconds : 0;
+}
+
+/**
+ * @brief Writes one row as CSV or as a JSON object.
+ */
+static void print_row(const BenchRow* row, int json, int first) { // one result line
+    if (json) {
+        printf("%s\n  {\"example\": %d, \"name\": \"%s\", \"iterations\": %d, \"length\": %zu, "
+            "\"generation_seconds\": %.9f, \"generation_bytes_per_second\": %.0f, "
+            "\"expand_seconds\": %.9f, \"expand_bytes_per_second\": %.0f, "
+            "\"parallel_seconds\": %.9f, \"parallel_bytes_per_second\": %.0f, "
+            "\"packed_bytes\": %zu, \"packed_seconds\": %.9f, "
+            "\"reallocs\": %zu, \"peak_rss_kb\": %ld, "
+            "\"segments\": %zu, \"turtle_seconds\": %.9f, \"segments_per_second\": %.0f}",
+            first ? "" : ",", row->example + 1, example_names[row->example], row->iterations, row->length,
+            row->generation_seconds, rate((double)row->length, row->generation_seconds),
+            row->expand_seconds, rate((double)row->length, row->expand_seconds),
+            row->parallel_seconds, rate((double)row->length, row->parallel_seconds),
+            row->packed_bytes, row->packed_seconds,
+            row->reallocs, row->peak_rss_kb,
+            row->segments, row->turtle_seconds, rate((double)row->segments, row->turtle_seconds));
+    } else {
+        printf("%d,%s,%d,%zu,%.9f,%.0f,%.9f,%.0f,%.9f,%.0f,%zu,%.9f,%zu,%ld,%zu,%.9f,%.0f\n",
+            row->example + 1, example_names[row->example], row->iterations, row->length,
+            row->generation_seconds, rate((double)row->length, row->generation_seconds),
+            row->expand_seconds, rate((double)row->length, row->expand_seconds),
+            row->parallel_seconds, rate((double)row->length, row->parallel_seconds),
+            row->packed_bytes, row->packed_seconds,
+            row->reallocs, row->peak_rss_kb,
+            row->segments, row->turtle_seconds, rate((double)row->segments, row->turtle_seconds));
+    }
+    fflush(stdout);
+}
+
+int main(int argc, char* argv[]) {
+    int json = 0;
+    int extra = 0;
+    size_t max_bytes = DEFAULT_MAX_BYTES;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            json = strcmp(argv[++i], "json") == 0;
+        } else if (strcmp(argv[i], "--extra") == 0 && i + 1 < argc) {
+            extra = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-bytes") == 0 && i + 1 < argc) {
+            max_bytes = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--buffers") == 0 && i + 1 < argc) {
+            buffer_backend = strcmp(argv[++i], "mapped") == 0 ? BUFFER_BACKEND_MAPPED : BUFFER_BACKEND_HEAP;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            parallel_threads = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--format csv|json] [--extra N] [--max-bytes N] [--buffers heap|mapped] [--threads N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (json) {
+        printf("[");
+    } else {
+        printf("example,name,iterations,length,generation_seconds,generation_bytes_per_second,"
+            "expand_seconds,expand_bytes_per_second,parallel_seconds,parallel_bytes_per_second,packed_bytes,packed_seconds,reallocs,peak_rss_kb,segments,turtle_seconds,segments_per_second\n");
+    }
+
+    int first = 1;
+    for (int example = 0; example < 10; example++) {
+        L_System sys = example_library[example];
+
+        for (int iterations = 1; iterations <= sys.iterations + extra; iterations++) {
+            BenchRow row;
+
+            if (!calculate_parsed_length(sys.axiom, sys.rules, iterations, &row.length) || row.length > max_bytes) {
+                continue;
+            }
+
+            if (!measure(example, iterations, &row)) {
+                fprintf(stderr, "%s at %d iterations failed\n", example_names[example], iterations);
+                break;
+            }
+
+            print_row(&row, json, first);
+            first = 0;
+        }
+    }
+
+    if (json) {
+        printf("\n]\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,38 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "l_system.h" // include the L-System struct that every batch job describes
+#include "bounds.h"
+#include "stats.h"
+#include <stddef.h>
+
+#define BATCH_PATH_SIZE 4096 // longest output path accepted for a job
+#define BATCH_LINE_SIZE 4096 // longest line accepted in a spec file
+
+typedef struct {
+    L_System system;
+    char name[64];
+    int has_system, rule_count;
+    int has_iterations, has_angle, has_start;
+    int iterations;
+    float turn_angle, start_direction;
+    char render_path[BATCH_PATH_SIZE];
+    char svg_path[BATCH_PATH_SIZE];
+    char output_path[BATCH_PATH_SIZE];
+    int size;
+    int dedup;
+    int visualize;
+    int analytic;
+
+    int ok;
+    char error[128];
+    size_t length, draw_count, move_count, segment_count;
+    size_t render_removed, svg_removed;
+    Bounds bounds;
+    SystemStats stats;
+    double seconds;
+} BatchJob; // one system to process in batch mode, its outputs, and the stats collected while processing it
+
+int run_batch(int argc, char* argv[], const L_System* examples, int example_count); // function prototype
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include "l_system.h" // include the Rule struct so bounds can be calculated from a rule set
+
+#define BOUNDS_MAX_HEADINGS 3600 // turn angles that need more heading classes than this are not memoized
+
+typedef struct {
+    double min_x, max_x, min_y, max_y;
+} Bounds; // extents of a drawing, in the same coordinates as `set_boundaries()`
+
+typedef struct {
+    double dx, dy;
+    int turn;
+    Bounds box;
+} TurtleSummary; // net effect of one expanded symbol on a turtle: displacement, heading change and the box it touches
+
+int count_heading_classes(double turn_angle);
+int calculate_bounds(const char* axiom, Rule rules[], int iterations, double turn_angle, double start_direction, Bounds* bounds); // function prototypes
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "l_system.h" // include the L-System struct so a whole system can be looked up
+#include "bounds.h"
+#include "turtle.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define CACHE_ENV "LSYSTEM_CACHE" // cache directory; the cache stays off unless it is set
+#define CACHE_LIMIT_ENV "LSYSTEM_CACHE_LIMIT" // most bytes the cache directory may hold
+#define CACHE_DEFAULT_LIMIT ((unsigned long long)1 << 30) // 1 GiB
+#define CACHE_ENTRY_FRACTION 4 // entries larger than the limit divided by this are not stored
+#define CACHE_PATH_SIZE 4096 // longest cache directory accepted
+#define CACHE_KEY_SIZE 1280 // longest key text: an axiom, every rule, the iterations and the turtle parameters
+#define CACHE_VERSION 1 // bump when the file layout changes, so old entries are ignored
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t kind;
+    uint64_t hash;
+    char key[CACHE_KEY_SIZE];
+    uint64_t count;
+    double bounds[4];
+    uint64_t draw_count, move_count;
+} CacheHeader; // start of every cache file: what it holds and the full key, compared on load so a hash collision is never a hit
+
+typedef struct {
+    void* map;
+    size_t map_size;
+    char* owned;
+    const char* string;
+    size_t length;
+    const float* segments;
+    size_t segment_count;
+    Bounds bounds;
+    size_t draw_count, move_count;
+} CacheEntry; // a parsed string or turtle geometry, either mapped read-only from a cache file or, for `owned`, freshly computed
+
+extern int cache_enabled; // nonzero once a cache directory is open
+
+int cache_open(const char* dir, unsigned long long limit);
+int cache_open_from_env();
+int cache_load_string(const L_System* sys, CacheEntry* entry);
+int cache_store_string(const L_System* sys, const char* string, size_t length);
+int cache_parse(const L_System* sys, CacheEntry* entry);
+int cache_load_geometry(const L_System* sys, CacheEntry* entry);
+int cache_store_geometry(const L_System* sys, const Turtle* turtle);
+void cache_entry_free(CacheEntry* entry); // function prototypes
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef DEDUP_H
+#define DEDUP_H
+
+#include "bounds.h" // include the Bounds struct that sizes the quantum to float32 precision
+#include <stddef.h>
+
+#define DEDUP_QUANTUM 0.001 // endpoints are snapped to this grid before comparing, widened by dedup_quantum()
+#define DEDUP_NEIGHBOUR 0.25 // fraction of the quantum within which endpoints always match, even across a grid line
+#define DEDUP_ULPS 8 // float32 steps at the largest coordinate that the quantum always covers
+#define DEDUP_MAX_QUANTUM 0.1 // never snap coarser than a tenth of a turtle step
+
+typedef struct {
+    long long endpoints[4];
+} SegmentKey; // quantized x0, y0, x1, y1 with the endpoints in a fixed order, so a segment matches its reverse
+
+typedef struct {
+    SegmentKey* keys;
+    unsigned char* used;
+    size_t capacity;
+    size_t size;
+    double quantum;
+} SegmentSet; // open-addressing hash set of segments, probed linearly; matching is approximate and compares whole segments, so partly overlapping runs are kept
+
+int segment_set_init(SegmentSet* set, double quantum);
+int segment_set_insert(SegmentSet* set, const float* segment, int* inserted);
+double dedup_quantum(double quantum, const Bounds* bounds);
+void segment_set_free(SegmentSet* set);
+int dedup_segments(float* segments, size_t* segment_count, double quantum, size_t* removed); // function prototypes
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef EXPANSION_H
+#define EXPANSION_H
+
+#include "l_system.h" // include the Rule struct so a handle can remember its grammar
+#include "rule_table.h"
+#include <stddef.h>
+
+#define EXPANSION_KEEP_LIMIT ((size_t)256 << 20) // bytes of earlier generations kept so lowering the iterations is free, 256 MiB
+
+typedef struct {
+    int valid;
+    char axiom[SIZE];
+    Rule rules[SIZE];
+    RuleTable table;
+    char** generations;
+    size_t* lengths;
+    int count;
+    int capacity;
+    size_t kept;
+} ExpansionHandle; // one grammar's compiled rules and computed generations: generations[i] is generation i, or NULL once dropped; 0 and count - 1 are always held
+
+void expansion_init(ExpansionHandle* handle);
+int expansion_matches(const ExpansionHandle* handle, const char* axiom, Rule rules[]);
+const char* expansion_get(ExpansionHandle* handle, const char* axiom, Rule rules[], int iterations, size_t* length);
+void expansion_free(ExpansionHandle* handle); // function prototypes
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef LENGTH_H
+#define LENGTH_H
+
+#include "l_system.h" // include the Rule struct so the transition matrix can be built from a rule set
+#include <stddef.h>
+
+typedef struct {
+    int size;
+    unsigned char symbols[256];
+    int index_of[256];
+    size_t* produces;
+} TransitionMatrix; // symbol-count transition matrix: produces[from * size + to] is how many `to` one `from` becomes
+
+int build_transition_matrix(TransitionMatrix* matrix, const char* axiom, Rule rules[]);
+void free_transition_matrix(TransitionMatrix* matrix);
+int calculate_generation_lengths(const char* axiom, Rule rules[], int iterations, size_t lengths[]);
+int calculate_parsed_length(const char* axiom, Rule rules[], int iterations, size_t* length);
+int calculate_buffer_size(const char* axiom, Rule rules[], int iterations, size_t* buffer_size); // function prototypes
+
+#endif
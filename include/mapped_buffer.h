@@ -0,0 +1,24 @@
+#ifndef MAPPED_BUFFER_H
+#define MAPPED_BUFFER_H
+
+#include <stddef.h>
+
+#define MAPPED_BUFFER_RESERVE ((size_t)1 << 36) // address space reserved per buffer, 64 GiB, only ever backed where committed
+#define MAPPED_BUFFER_STEP ((size_t)2 << 20) // commit granularity and alignment, one 2 MiB huge page
+#define MAPPED_BUFFER_DISCARD_MIN ((size_t)64 << 20) // smaller buffers keep their pages, refaulting them costs more than they hold
+#define MAPPED_BUFFER_MAX 64 // most mapped buffers alive at once; more fall back to the heap
+
+typedef struct {
+    char* base;
+    size_t reserved;
+    size_t committed;
+    int huge;
+} MappedBuffer; // one reserved range: its start, its length, how much of it is readable and writable, and whether it uses hugetlb pages
+
+char* mapped_buffer_create(size_t size);
+int mapped_buffer_grow(char* buffer, size_t size);
+int mapped_buffer_discard(char* buffer);
+int mapped_buffer_release(char* buffer);
+int mapped_buffer_owns(const char* buffer); // function prototypes
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef OUT_OF_CORE_H
+#define OUT_OF_CORE_H
+
+#include "l_system.h" // include the Rule struct so the file parser can accept a rule set
+#include <stddef.h>
+
+#define OUT_OF_CORE_WINDOW ((size_t)64 << 20) // bytes of the output file mapped for writing at a time, a multiple of the page size
+
+typedef struct {
+    const char* data;
+    size_t length;
+    size_t mapped_size;
+} MappedString; // a parsed string mapped read-only from its file, followed by a zero page so it is null-terminated
+
+int parser_to_file(const char* axiom, Rule rules[], int iterations, const char* path, MappedString* result);
+void mapped_string_free(MappedString* string); // function prototypes
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef PACKED_H
+#define PACKED_H
+
+#include "l_system.h" // include the Rule struct so an alphabet can be gathered from a rule set
+#include "rule_table.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define PACKED_NIBBLE_CODES 16 // alphabets up to this size are packed two symbols per byte
+#define PACKED_BODY_WORDS ((SIZE * 8 + 63) / 64) // 64-bit words holding the longest rule body at 8 bits per symbol
+#define PACKED_PADDING 8 // bytes past the end of a packed buffer, so the kernel can always store whole words
+
+typedef struct {
+    unsigned char code[256];
+    char symbol[256];
+    char pair[256][2];
+    int count;
+    int bits;
+} PackedAlphabet; // the symbols of a grammar: symbol to code, code to symbol, each byte decoded as two 4-bit codes, and the code width (4 or 8)
+
+typedef struct {
+    uint64_t body[256][PACKED_BODY_WORDS];
+    size_t length[256];
+    unsigned char has_rule[256];
+    uint64_t pair_body[256][PACKED_BODY_WORDS];
+    size_t pair_length[256];
+} PackedRules; // expansions already packed at the alphabet's width, by code, and for 4-bit alphabets by whole byte (two codes)
+
+typedef struct {
+    unsigned char* data;
+    size_t length;
+    PackedAlphabet alphabet;
+} PackedString; // a parsed string of `length` symbols at `alphabet.bits` per symbol, from `parser_packed()`
+
+/**
+ * @brief Returns the code of the symbol at an index of a packed buffer.
+ */
+static inline unsigned char packed_code_at(const unsigned char* data, int bits, size_t index) { // one symbol, still encoded
+    return bits == 4 ? (data[index >> 1] >> ((index & 1) * 4)) & 0xF : data[index];
+}
+
+int packed_alphabet_build(PackedAlphabet* alphabet, const char* axiom, Rule rules[]);
+int packed_size(const PackedAlphabet* alphabet, size_t symbols, size_t* bytes);
+void packed_encode(const PackedAlphabet* alphabet, const char* symbols, size_t count, unsigned char* data);
+void packed_decode(const PackedString* string, size_t start, size_t count, char* symbols);
+void packed_rules_compile(PackedRules* packed, const RuleTable* table, const PackedAlphabet* alphabet);
+void packed_string_free(PackedString* string); // function prototypes
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "l_system.h" // include the Rule struct so the parallel parser can accept a rule set
+#include "rule_table.h"
+#include <stddef.h>
+
+#define PARALLEL_MIN_CHUNK 65536 // generations shorter than this per thread are expanded on one thread
+
+int resolve_thread_count(int threads);
+size_t iterate_parallel(const char* current_buffer, size_t current_length, char* next_buffer, const RuleTable* table, int threads);
+char* parser_parallel(const char* axiom, Rule rules[], int iterations, int threads); // function prototypes
+
+#endif
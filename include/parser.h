@@ -2,14 +2,31 @@
 #define PARSER_H
 
 #include "l_system.h" // include the L-System struct so the parser function can accept one
+#include "rule_table.h"
+#include "packed.h"
 #include <stddef.h>
 
-double calculate_growth_factor(Rule rules[]);
-size_t calculate_buffer_size(size_t axiom_len, double growth_factor, int iterations);
+#define BUFFER_BACKEND_ENV "LSYSTEM_BUFFERS" // set to "mapped" to allocate the ping-pong buffers with mmap
+
+typedef enum {
+    BUFFER_BACKEND_HEAP,
+    BUFFER_BACKEND_MAPPED
+} BufferBackend; // where buffer_allocate() gets memory: malloc and realloc, or reserved ranges that grow in place
+
+extern size_t buffer_resize_count; // reallocations made by buffer_resize()
+extern BufferBackend buffer_backend; // backend used by buffer_allocate()
+
+void buffer_backend_from_env();
 int buffer_allocate(char** current_buffer, char** next_buffer, size_t buffer_size);
 char* buffer_resize(char* buffer, size_t needed_size, size_t* buffer_size);
-int iterate(char* current_buffer, char** next_buffer, size_t* buffer_size, Rule rules[], double growth_factor);
+void buffer_discard(char* buffer);
+void buffer_release(char* buffer);
+int iterate(char* current_buffer, char** next_buffer, size_t* buffer_size, const RuleTable* table);
 char* parser(const char* axiom, Rule rules[], int iterations); 
-char* finalize_parser(char* buffer);
+char* parser_breadth_first(const char* axiom, Rule rules[], int iterations);
+size_t packed_iterate(const unsigned char* current_buffer, size_t current_length, unsigned char* next_buffer, const PackedRules* rules, int bits);
+int parser_packed(const char* axiom, Rule rules[], int iterations, PackedString* result);
+char parser_symbol_at(const char* axiom, Rule rules[], int iterations, size_t index);
+char* parser_substring(const char* axiom, Rule rules[], int iterations, size_t start, size_t end);
 
 #endif
\ No newline at end of file
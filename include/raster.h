@@ -0,0 +1,25 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include "bounds.h" // include the Bounds struct so segments can be fitted to the image
+#include <stddef.h>
+
+typedef struct {
+    unsigned char r, g, b, a;
+} Color;
+
+typedef struct {
+    int width;
+    int height;
+    unsigned char* pixels;
+} Framebuffer; // in-memory RGBA image, 4 bytes per pixel, rows top to bottom
+
+int framebuffer_init(Framebuffer* frame, int width, int height, Color background);
+void framebuffer_free(Framebuffer* frame);
+void draw_line(Framebuffer* frame, double x0, double y0, double x1, double y1, Color color);
+void draw_segments(Framebuffer* frame, const float* segments, size_t segment_count, const Bounds* bounds, Color color);
+int write_ppm(const Framebuffer* frame, const char* path);
+int write_png(const Framebuffer* frame, const char* path);
+int write_image(const Framebuffer* frame, const char* path); // function prototypes
+
+#endif
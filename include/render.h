@@ -0,0 +1,12 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "l_system.h" // include the L-System struct so a whole system can be rendered
+#include "turtle.h"
+#include <stddef.h>
+
+#define RENDER_DEFAULT_SIZE 800 // matches the visualizer window size
+
+int render_system(L_System* sys, int width, int height, const char* path, int dedup, size_t* removed, TurtleTotals* totals); // function prototype
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef ROPE_H
+#define ROPE_H
+
+#include "l_system.h" // include the Rule struct so a rope can be built from a rule set
+#include "rule_table.h"
+#include "stream.h"
+#include <stddef.h>
+
+typedef struct {
+    char axiom[SIZE];
+    Rule* rules;
+    RuleTable table;
+    int iterations;
+    int rule_index[256];
+    size_t* node_length;
+    size_t length;
+} LRope; // one node per (rule symbol, remaining depth): node_length[depth * rule_count + rule_index[symbol]]
+
+int rope_build(LRope* rope, const char* axiom, Rule rules[], int iterations);
+size_t rope_symbol_length(const LRope* rope, unsigned char symbol, int depth);
+char rope_symbol_at(const LRope* rope, size_t index);
+int rope_stream(const LRope* rope, size_t start, LStream* stream);
+size_t rope_materialize(const LRope* rope, size_t start, size_t end, char* out);
+void rope_free(LRope* rope); // function prototypes
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef RULE_TABLE_H
+#define RULE_TABLE_H
+
+#include "l_system.h" // include the Rule struct so a rule set can be compiled
+#include <stddef.h>
+
+typedef struct {
+    const char* expansion[256];
+    size_t length[256];
+    unsigned char has_rule[256];
+    unsigned char rule_symbols[256];
+    int rule_count;
+    char* arena;
+} RuleTable; // byte-indexed expansion of every symbol, with all bodies pooled in one arena
+
+int compile_rules(RuleTable* table, Rule rules[]);
+void free_rule_table(RuleTable* table); // function prototypes
+
+#endif
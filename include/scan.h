@@ -0,0 +1,42 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include "rule_table.h" // include the RuleTable struct so the scanners know which symbols have rules
+#include <stddef.h>
+
+#define SCAN_MAX_RULE_SYMBOLS 8 // rule sets with more symbols than this are scanned one byte at a time
+#define SCAN_SHORT_RUN 16 // runs are checked byte by byte up to this length before a vector scanner takes over
+
+typedef size_t (*RunScanner)(const char* buffer, size_t length, const RuleTable* table);
+
+size_t scan_long_run(const char* buffer, size_t length, const RuleTable* table);
+const char* scanner_name(); // function prototypes
+
+/**
+ * @brief Measures the run of symbols without a rule at the start of a buffer.
+ *
+ * Most runs in real grammars are a few symbols long, so the first `SCAN_SHORT_RUN`
+ * symbols are checked inline and only longer runs pay for a call into the vector
+ * scanner selected by `scan_long_run()`.
+ *
+ * @param buffer The symbols to scan.
+ * @param length The number of symbols to scan.
+ * @param table The compiled rule table.
+ *
+ * @return The number of leading symbols without a rule, from 0 to `length`.
+ */
+static inline size_t scan_constant_run(const char* buffer, size_t length, const RuleTable* table) { // length of the next pass-through run
+    size_t i = 0;
+
+    while (i < length && i < SCAN_SHORT_RUN && !table->has_rule[(unsigned char)buffer[i]]) {
+        i++;
+    }
+
+    if (i < SCAN_SHORT_RUN || i == length) {
+        return i;
+    }
+
+    return i + scan_long_run(buffer + i, length - i, table);
+}
+
+#endif
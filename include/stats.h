@@ -0,0 +1,25 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "l_system.h" // include the Rule struct so statistics can be calculated from a rule set
+#include <stddef.h>
+
+typedef unsigned __int128 StatCount; // 128-bit symbol counter, saturating at STAT_COUNT_MAX
+#define STAT_COUNT_MAX (~(StatCount)0) // a count this large means "at least this large"
+#define STAT_COUNT_DIGITS 40 // decimal digits of the largest count, plus the terminator
+
+typedef struct {
+    unsigned long long iterations;
+    int size;
+    unsigned char symbols[256];
+    StatCount counts[256];
+    StatCount length, draws, moves, turns, pushes, pops;
+    long long max_depth;
+    int saturated;
+} SystemStats; // symbol counts of one generation and the totals derived from them; max_depth is -1 when the brackets do not allow it to be calculated
+
+int calculate_stats(const char* axiom, Rule rules[], unsigned long long iterations, SystemStats* stats);
+void format_stat_count(StatCount count, char* text);
+void print_stats(const SystemStats* stats); // function prototypes
+
+#endif
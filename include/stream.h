@@ -0,0 +1,31 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "l_system.h" // include the Rule struct so the stream can be built from a rule set
+#include "rule_table.h"
+#include <stddef.h>
+
+#define STREAM_CHUNK_SIZE 65536 // size of the chunk used when draining a stream into a consumer
+
+typedef struct {
+    char symbol;
+    int depth;
+    size_t offset;
+    const char* body;
+    size_t length;
+} StreamFrame; // one pending expansion: the rule body of a symbol, its remaining depth, and the read offset into it
+
+typedef struct {
+    RuleTable table;
+    StreamFrame* stack;
+    int top;
+} LStream; // depth-first expansion state, bounded by the number of iterations
+
+typedef int (*StreamConsumer)(const char* symbols, size_t count, void* context);
+
+int stream_init(LStream* stream, const char* axiom, Rule rules[], int iterations);
+size_t stream_read(LStream* stream, char* chunk, size_t chunk_size);
+int stream_drain(LStream* stream, StreamConsumer consumer, void* context);
+void stream_free(LStream* stream); // function prototypes
+
+#endif
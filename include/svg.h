@@ -0,0 +1,26 @@
+#ifndef SVG_H
+#define SVG_H
+
+#include "l_system.h" // include the L-System struct so a whole system can be exported
+#include "dedup.h"
+#include "turtle.h"
+#include <stdio.h>
+#include <stddef.h>
+
+#define SVG_BUFFER_SIZE 1048576 // path data is written to the file in blocks of this size
+
+typedef struct {
+    FILE* file;
+    char* buffer;
+    size_t used;
+    int ok;
+    SegmentSet* dedup;
+    size_t segments;
+    size_t removed;
+    int broken;
+} SvgWriter; // fixed-size output buffer flushed with large sequential writes, optionally skipping repeated segments; counts every segment it is given
+
+int svg_segment(const float* segment, int continues, void* context);
+int export_svg(L_System* sys, const char* path, int dedup, size_t* removed, TurtleTotals* totals); // function prototypes
+
+#endif
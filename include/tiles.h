@@ -0,0 +1,42 @@
+#ifndef TILES_H
+#define TILES_H
+
+#include "bounds.h" // include the Bounds struct so the pyramid can be fitted around the drawing
+#include "raster.h" // include the Framebuffer struct that holds each tile's pixels
+#include <stddef.h>
+
+#define TILE_SIZE 256 // width and height of every tile, in pixels
+#define TILE_MAX_LEVELS 10 // level l has 2^l by 2^l tiles, so the finest level is 512 tiles across
+#define TILE_MAX_ZOOM 16 // the finest level stops once one turtle step spans this many pixels
+#define TILE_PRERENDERED_LEVELS 3 // coarse levels rasterized when the pyramid is built and never evicted
+#define TILE_BUCKET_LEVEL 6 // segments are bucketed on the grid of this level to find the ones a tile touches
+#define TILE_CACHE_LIMIT 256 // lazily rasterized tiles kept before the least recently used is evicted
+#define TILE_MIN_SYMBOLS 4000000 // parsed strings at least this long are viewed through a tile pyramid, well above every example in the library
+
+typedef struct {
+    Framebuffer frame;
+    int level, x, y;
+    unsigned long last_used;
+} Tile; // one rasterized square of the pyramid
+
+typedef struct {
+    const float* segments;
+    size_t segment_count;
+    double origin_x, origin_y, world_size;
+    int levels;
+    int grid;
+    size_t* cell_start;
+    size_t* cell_segments;
+    unsigned int* drawn;
+    unsigned int stamp;
+    Tile** tiles[TILE_MAX_LEVELS];
+    Tile** cache;
+    size_t cache_count;
+    unsigned long clock;
+} TilePyramid; // multi-resolution tiles over a square world: coarse levels prebuilt, fine levels rasterized on demand
+
+int tile_pyramid_build(TilePyramid* pyramid, const float* segments, size_t segment_count, const Bounds* bounds);
+const Framebuffer* tile_pyramid_get(TilePyramid* pyramid, int level, int x, int y);
+void tile_pyramid_free(TilePyramid* pyramid); // function prototypes
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#define TRACE_ENV "LSYSTEM_TRACE" // set to a file path to write a trace of the run
+#define TRACE_NAME_SIZE 48 // longest span or counter name kept, including the terminator
+
+typedef struct {
+    char name[TRACE_NAME_SIZE];
+    char phase;
+    int thread;
+    double start, duration;
+    char arg_name[TRACE_NAME_SIZE];
+    double arg_value;
+} TraceEvent; // one Chrome trace event: a complete span ('X'), an instant ('i') or a counter sample ('C'), times in microseconds
+
+extern int trace_enabled; // nonzero while a trace is being recorded
+
+int trace_start(const char* path);
+int trace_start_from_env();
+void trace_stop();
+double trace_clock();
+void trace_record(char phase, const char* name, double start, double end, const char* arg_name, double arg_value); // function prototypes
+
+/**
+ * @brief Starts a span, returning its start time, or 0 without reading the clock when tracing is off.
+ */
+static inline double trace_begin() { // open a span
+    return trace_enabled ? trace_clock() : 0;
+}
+
+/**
+ * @brief Ends a span started by `trace_begin()`, with an optional numeric argument.
+ *
+ * @param name The span name.
+ * @param start The value returned by `trace_begin()`.
+ * @param arg_name The argument name, or NULL for none.
+ * @param arg_value The argument value.
+ */
+static inline void trace_end(const char* name, double start, const char* arg_name, double arg_value) { // close a span
+    if (trace_enabled) {
+        trace_record('X', name, start, trace_clock(), arg_name, arg_value);
+    }
+}
+
+/**
+ * @brief Records a point event, such as an allocation, with an optional numeric argument.
+ */
+static inline void trace_instant(const char* name, const char* arg_name, double arg_value) { // mark a moment
+    if (trace_enabled) {
+        double now = trace_clock();
+        trace_record('i', name, now, now, arg_name, arg_value);
+    }
+}
+
+/**
+ * @brief Records a sample of a counter, drawn as a graph by the trace viewer.
+ */
+static inline void trace_counter(const char* name, double value) { // sample a counter
+    if (trace_enabled) {
+        double now = trace_clock();
+        trace_record('C', name, now, now, name, value);
+    }
+}
+
+#endif
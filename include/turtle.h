@@ -0,0 +1,55 @@
+#ifndef TURTLE_H
+#define TURTLE_H
+
+#include "packed.h"
+#include "bounds.h"
+#include <stddef.h>
+
+#define TURTLE_DECODE_CHUNK 4096 // symbols of a packed string decoded at a time
+
+typedef struct {
+    double x;
+    double y;
+    double direction;
+} TurtleState; // position and heading, as saved by '[' and restored by ']'
+
+typedef int (*TurtleSink)(const float* segment, int continues, void* context); // receives each segment instead of the segment array
+
+typedef struct {
+    float* segments;
+    size_t segment_count;
+    size_t segment_capacity;
+    size_t draw_count;
+    size_t move_count;
+    double min_x, max_x, min_y, max_y;
+    double turn_angle;
+    TurtleState state;
+    double step_x, step_y;
+    TurtleState* stack;
+    size_t stack_size;
+    size_t stack_capacity;
+    TurtleSink sink;
+    void* sink_context;
+    int continues;
+    int pending;
+    double pending_x, pending_y;
+    int pending_continues;
+} Turtle; // one-pass turtle interpreter: packed segments (x0, y0, x1, y1 as float32), bounds and step counts
+
+typedef struct {
+    size_t draw_count;
+    size_t move_count;
+    size_t segment_count;
+    Bounds bounds;
+} TurtleTotals; // what a finished turtle drew, for callers that report it: step counts, segments before any dedup, and bounds
+
+int turtle_init(Turtle* turtle, double turn_angle, double start_direction);
+int turtle_feed(Turtle* turtle, const char* symbols, size_t count);
+int turtle_consume(const char* symbols, size_t count, void* context);
+int turtle_interpret(Turtle* turtle, const char* parsed);
+int turtle_feed_packed(Turtle* turtle, const PackedString* packed);
+int turtle_finish(Turtle* turtle);
+void turtle_totals(const Turtle* turtle, size_t segment_count, TurtleTotals* totals);
+void turtle_free(Turtle* turtle); // function prototypes
+
+#endif
@@ -1,8 +1,10 @@
 #ifndef VISUALIZER_CONFIG_H
 #define VISUALIZER_CONFIG_H
 
+#include "bounds.h" // include the Bounds struct so precomputed bounds can be passed to the visualizer
+
 void initialize_python();
 void finalize_python();
-void visualize(const char* parsed, double turn_angle, double start_direction); // function prototypes
+void visualize(const char* parsed, double turn_angle, double start_direction, const Bounds* bounds); // function prototypes
 
 #endif
\ No newline at end of file
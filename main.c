@@ -1,6 +1,12 @@
 #include "app.h"
 #include "l_system.h"
 #include "parser.h"
+#include "bounds.h"
+#include "stats.h"
+#include "cache.h"
+#include "expansion.h"
+#include "batch.h"
+#include "trace.h"
 #include "visualizer_config.h"
 #include "example_library.h"
 #include "validation.h" // include all header files
@@ -14,23 +20,52 @@
 /**
  * @brief The main entry point of the program.
  *
- * The main function initializes the python environment using `initialize_python()`,
- * prints a welcome message, and then enters a loop to repeatedly show the main
- * menu and execute the user's selection. The loop continues until the user
- * chooses the exit option.
+ * The main function prints a welcome message, and then enters a loop to repeatedly
+ * show the main menu and execute the user's selection. The loop continues until the
+ * user chooses the exit option. The python environment is only initialized with
+ * `initialize_python()` the first time a system is visualized. Systems are expanded
+ * through one `ExpansionHandle`, so trying the same grammar again with more or fewer
+ * iterations resumes from, or returns, a generation already computed.
  *
- * @return 0 if the program executes successfull./appy.
+ * Given any command line arguments, the program runs in batch mode with `run_batch()`
+ * instead: the systems described by the options or spec files are processed, rendered
+ * or exported, and their stats printed, without any menus and without starting Python
+ * unless one asks to be visualized. Run with `--help` to list the options.
+ *
+ * Set the `LSYSTEM_TRACE` environment variable to a file path to record a Chrome trace
+ * of the run, in either mode, with `trace_start_from_env()`. Set `LSYSTEM_BUFFERS` to
+ * `mapped` to allocate the parser's ping-pong buffers with the mmap backend. Parsed
+ * systems are cached on disk by `cache_open_from_env()` only when `LSYSTEM_CACHE` names
+ * a directory, and `LSYSTEM_CACHE_LIMIT` sets its size in bytes.
+ *
+ * @param argc The number of command line arguments.
+ * @param argv The command line arguments.
+ *
+ * @return 0 if the program executes successfully, 1 if a batch system fails.
  */
-int main (void) {
+int main (int argc, char* argv[]) {
     _Bool exit_program = 0;
     int start_input;
 
     int example_input;
     L_System ExampleData;
     L_System CustomData;
-    char* parsed_system;
+    CacheEntry parsed_system;
+    ExpansionHandle expansion; // generations of the last grammar parsed, reused when only the iterations change
+    Bounds bounds;
+    int has_bounds;
+    SystemStats stats;
+    _Bool python_ready = 0;
+
+    trace_start_from_env(); // only records when LSYSTEM_TRACE is set
+    buffer_backend_from_env(); // LSYSTEM_BUFFERS=mapped selects the mmap buffer backend
+    cache_open_from_env(); // the on-disk cache is off unless LSYSTEM_CACHE names a directory
+
+    if (argc > 1) { // batch mode, no menus and no python unless a system asks for the GUI
+        return run_batch(argc, argv, example_library, 10);
+    }
 
-    initialize_python(); // setup python environment
+    expansion_init(&expansion);
 
     printf("***** L-System Parser v1.0.0 *****" "\n\n");
     printf("This program explores the mathematical theory of Lindenmayer(L)-Systems." "\n\n");
@@ -50,21 +85,39 @@ int main (void) {
 
                 ExampleData = example_library[example_input]; // create example data struct with proper data
                 print_system(ExampleData); // print example data details
+                if (calculate_stats(ExampleData.axiom, ExampleData.rules, (unsigned long long)ExampleData.iterations, &stats)) {
+                    print_stats(&stats); // how big it will get, before expanding it
+                }
                 
-                parsed_system = parser(ExampleData.axiom, ExampleData.rules, ExampleData.iterations); // parse example data
+                if (!cache_load_string(&ExampleData, &parsed_system)) { // parse example data, resuming from the last run of the same grammar
+                    parsed_system.string = expansion_get(&expansion, ExampleData.axiom, ExampleData.rules, ExampleData.iterations, &parsed_system.length);
+                    if (!parsed_system.string) {
+                        printf("ERROR: The parsed system is too large to store." "\n\n");
+                        break;
+                    }
+                    cache_store_string(&ExampleData, parsed_system.string, parsed_system.length);
+                }
                 
-                printf("Result: %ld" "\n\n", strlen(parsed_system)); // print parsed system length
+                printf("Result: %zu" "\n\n", parsed_system.length); // print parsed system length
 
                 printf("Enter any key to visualize the system: (ensure to close the GUI window to proceed): "); 
                 getchar();
 
-                visualize(parsed_system, ExampleData.turn_angle, ExampleData.start_direction); // visualize example data
+                if (!python_ready) { // setup python environment on first use
+                    initialize_python();
+                    python_ready = 1;
+                }
+                has_bounds = calculate_bounds(ExampleData.axiom, ExampleData.rules, ExampleData.iterations, ExampleData.turn_angle, ExampleData.start_direction, &bounds); // skip the bounds walk when possible
+                visualize(parsed_system.string, ExampleData.turn_angle, ExampleData.start_direction, has_bounds ? &bounds : NULL); // visualize example data
+                cache_entry_free(&parsed_system);
 
                 printf("\n\n");
                 break;
             case 3: // custom menu option
                 print_custom_menu();
 
+                memset(&CustomData, 0, sizeof(CustomData)); // clear any previous system so the rule list ends after the new rules
+
                 validate_axiom(CustomData.axiom);
                 rules_for(CustomData.axiom, CustomData.rules_for_indices);
                 validate_rules(CustomData.rules, CustomData.axiom, CustomData.rules_for_indices); // intialize custom data struct with proper data
@@ -76,15 +129,31 @@ int main (void) {
                 flush_buffer(); // flush line buffer after any scanf() use 
 
                 print_system(CustomData); // print custom data details
-
-                parsed_system = parser(CustomData.axiom, CustomData.rules, CustomData.iterations); // parse custom data
+                if (calculate_stats(CustomData.axiom, CustomData.rules, (unsigned long long)CustomData.iterations, &stats)) {
+                    print_stats(&stats); // how big it will get, before expanding it
+                }
+
+                if (!cache_load_string(&CustomData, &parsed_system)) { // parse custom data, resuming from the last run of the same grammar
+                    parsed_system.string = expansion_get(&expansion, CustomData.axiom, CustomData.rules, CustomData.iterations, &parsed_system.length);
+                    if (!parsed_system.string) {
+                        printf("ERROR: The parsed system is too large to store." "\n\n");
+                        break;
+                    }
+                    cache_store_string(&CustomData, parsed_system.string, parsed_system.length);
+                }
                 
-                printf("Result: %ld" "\n\n", strlen(parsed_system)); // print parsed system length
+                printf("Result: %zu" "\n\n", parsed_system.length); // print parsed system length
 
                 printf("Enter any key to visualize the system: (ensure to close the GUI window to proceed): ");
                 getchar();
 
-                visualize(parsed_system, CustomData.turn_angle, CustomData.start_direction); // visualize custom data
+                if (!python_ready) { // setup python environment on first use
+                    initialize_python();
+                    python_ready = 1;
+                }
+                has_bounds = calculate_bounds(CustomData.axiom, CustomData.rules, CustomData.iterations, CustomData.turn_angle, CustomData.start_direction, &bounds); // skip the bounds walk when possible
+                visualize(parsed_system.string, CustomData.turn_angle, CustomData.start_direction, has_bounds ? &bounds : NULL); // visualize custom data
+                cache_entry_free(&parsed_system);
 
                 printf("\n\n");
                 break;
@@ -98,7 +167,10 @@ int main (void) {
         
     }
 
-    finalize_python(); // teardown python environment
+    if (python_ready) {
+        finalize_python(); // teardown python environment
+    }
+    expansion_free(&expansion);
     return 0;
 }
 
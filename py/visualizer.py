@@ -1,11 +1,88 @@
 import math # import math for trigonometry and angles.
 import sys # import sys to create an QApplication class.
-from PyQt5.QtWidgets import QApplication, QGraphicsView, QGraphicsScene, QMainWindow # import PyQt graphic libraries for creating the GUI.
-from PyQt5.QtGui import QPen, QColor, QBrush, QPainter # import PyQt drawing libraries for drawing the system.
-from PyQt5.QtCore import Qt, QTimer # import PyQt core libraries for running the animation.
+from collections import OrderedDict # import OrderedDict to keep recently used tiles.
+from PyQt5.QtWidgets import QApplication, QGraphicsView, QGraphicsScene, QGraphicsItem, QStyleOptionGraphicsItem, QMainWindow # import PyQt graphic libraries for creating the GUI.
+from PyQt5.QtGui import QPen, QColor, QBrush, QPainter, QPainterPath, QImage # import PyQt drawing libraries for drawing the system.
+from PyQt5.QtCore import Qt, QTimer, QRectF # import PyQt core libraries for running the animation.
+try:
+    import lsystem_trace # built into the C program, which records these spans into its trace file.
+except ImportError:
+    lsystem_trace = None # running the visualizer on its own, so there is nothing to trace into.
+
+class ZoomableView(QGraphicsView):
+    """
+    A QGraphicsView that zooms around the cursor with the mouse wheel and pans by dragging.
+    """
+    def __init__(self, scene) -> None:
+        super().__init__(scene)
+        self.setTransformationAnchor(QGraphicsView.AnchorUnderMouse) # zoom towards the cursor.
+        self.setDragMode(QGraphicsView.ScrollHandDrag) # drag to pan.
+
+    def wheelEvent(self, event) -> None:
+        factor = 1.25 ** (event.angleDelta().y() / 120) # one wheel notch zooms by 25%.
+        self.scale(factor, factor)
+
+class TileLayer(QGraphicsItem):
+    """
+    A graphics item that draws a level-of-detail tile pyramid rasterized by the C side.
+
+    Each paint picks the pyramid level whose tiles have about one pixel per screen pixel at the current zoom, and only fetches and draws the tiles that intersect the exposed area.
+    Converted tiles are kept in a small cache, so panning over tiles already seen does not cross back into C.
+    """
+    cache_limit = 512 # most QImages kept at once.
+
+    def __init__(self, tiles, fetch_tile) -> None:
+        """
+        Parameters:
+        tiles (tuple): The (origin_x, origin_y, world_size, levels, tile_size) of the pyramid, in scene coordinates.
+        fetch_tile (callable): Returns the RGBA bytes of the tile at (level, x, y).
+        """
+        super().__init__()
+        self.origin_x, self.origin_y, self.world_size, self.levels, self.tile_size = tiles
+        self.fetch_tile = fetch_tile
+        self.images = OrderedDict() # QImages by (level, x, y), least recently used first.
+        self.setFlag(QGraphicsItem.ItemUsesExtendedStyleOption) # fill in exposedRect so only visible tiles are drawn.
+
+    def boundingRect(self) -> QRectF:
+        return QRectF(self.origin_x, self.origin_y, self.world_size, self.world_size)
+
+    def tile_image(self, level, x, y) -> QImage:
+        """
+        Returns the QImage of one tile, fetching it from the pyramid on first use.
+        """
+        key = (level, x, y)
+        if key in self.images:
+            self.images.move_to_end(key)
+            return self.images[key]
+
+        pixels = self.fetch_tile(level, x, y)
+        image = QImage(pixels, self.tile_size, self.tile_size, QImage.Format_RGBA8888).copy() # copy so the image owns its pixels.
+        self.images[key] = image
+        if len(self.images) > self.cache_limit:
+            self.images.popitem(last=False)
+        return image
+
+    def paint(self, painter, option, widget=None) -> None:
+        scale = QStyleOptionGraphicsItem.levelOfDetailFromTransform(painter.worldTransform()) # screen pixels per scene unit.
+        texels = scale * self.world_size / self.tile_size # level 0 texels needed per screen pixel, doubling each level.
+        level = min(max(math.ceil(math.log2(texels)), 0) if texels > 0 else 0, self.levels - 1)
+
+        count = 2 ** level
+        size = self.world_size / count
+        exposed = option.exposedRect
+        first_x = max(int((exposed.left() - self.origin_x) // size), 0)
+        last_x = min(int((exposed.right() - self.origin_x) // size), count - 1)
+        first_y = max(int((exposed.top() - self.origin_y) // size), 0)
+        last_y = min(int((exposed.bottom() - self.origin_y) // size), count - 1)
+
+        painter.setRenderHint(QPainter.SmoothPixmapTransform)
+        for y in range(first_y, last_y + 1):
+            for x in range(first_x, last_x + 1):
+                target = QRectF(self.origin_x + x * size, self.origin_y + y * size, size, size)
+                painter.drawImage(target, self.tile_image(level, x, y))
 
 class LSystemVisualizer(QMainWindow): 
-    def __init__(self, parsed_system, turn_angle, starting_direction) -> None:
+    def __init__(self, parsed_system, turn_angle, starting_direction, boundaries=None, tiles=None) -> None:
         """
         Initializes a new LSystemVisualizer object.
         Creates application instance, scene, view, and drawing tools.
@@ -13,9 +90,11 @@ class LSystemVisualizer(QMainWindow):
         Parameters:
         drawing_color (str): The color of the drawing.
         background_color (str): The color of the background of the visualization.
-        parsed_system (str): The fully parsed L-System.
+        parsed_system (memoryview | bytes | str): The fully parsed L-System. The C side passes a read-only memoryview over its own buffer, which is used as is without copying; a str is encoded once.
         turn_angle (float): The angle at which to turn left or right.
         starting_direction (float): The starting direction of the visualization's drawing.
+        boundaries (tuple | None): The (min_x, max_x, min_y, max_y) of the drawing when already known, which skips the walk in set_boundaries().
+        tiles (tuple | None): The (origin_x, origin_y, world_size, levels, tile_size) of a tile pyramid built by the C side for a huge system. The system is then shown as tiles through the `lsystem_tiles` module instead of being animated.
         """
         if not QApplication.instance(): # create a new QApplication instance if there is not already one.
             self.app = QApplication(sys.argv)
@@ -36,19 +115,29 @@ class LSystemVisualizer(QMainWindow):
 
         self.plot_color = QColor('red')
         self.plot_background = QColor('white')
-        self.parsed = parsed_system
+        if isinstance(parsed_system, str): # a str is only passed when running the visualizer on its own.
+            parsed_system = parsed_system.encode('ascii')
+        self.parsed = parsed_system # keep the memoryview itself: a derived view would outlive its release on the C side.
         self.turn_angle = turn_angle
         self.starting_direction = starting_direction
         self.path_items = [] # declare initial variables.
+        self.trace = lsystem_trace if lsystem_trace is not None and lsystem_trace.enabled() else None # only time stages when a trace is running.
 
-        self.boundaries = self.set_boundaries()
+        if boundaries is not None:
+            self.boundaries = list(boundaries)
+        else:
+            start = self.trace.now() if self.trace else 0
+            self.boundaries = self.set_boundaries()
+            if self.trace:
+                self.trace.span("set_boundaries", start, "symbols", len(self.parsed))
         self.min_x = self.boundaries[0]
         self.max_x = self.boundaries[1]
         self.min_y = self.boundaries[2]
         self.max_y = self.boundaries[3] # get the boundaries of the L-System drawing.
 
         self.scene = QGraphicsScene() # create a new scene object.
-        self.view = QGraphicsView(self.scene) # create a new view object of the scene.
+        self.scene.setItemIndexMethod(QGraphicsScene.NoIndex) # the drawing is static once added, so skip maintaining a BSP index.
+        self.view = ZoomableView(self.scene) # create a new view object of the scene.
         self.view.setRenderHint(QPainter.Antialiasing) # set the rendering hint for the view to antialiasing for smooth lines.
         self.setCentralWidget(self.view) # create a central widget for the main window to hold the main content of the application.
 
@@ -59,6 +148,12 @@ class LSystemVisualizer(QMainWindow):
         self.set_frame() # set the frame of the visualization scene based on the boundaries.
         self.set_starting_point() # set the starting point for the visualization.
 
+        self.tile_layer = None
+        if tiles is not None: # draw precomputed tiles instead of animating every segment.
+            import lsystem_tiles # built into the C program, so only importable when tiles were built.
+            self.tile_layer = TileLayer(tiles, lsystem_tiles.tile)
+            self.scene.addItem(self.tile_layer)
+
         self.timer = QTimer() # create a new timer object.
         self.timer.timeout.connect(self.update_frame) # connect the timeout signal to the update_frame method.
         
@@ -80,7 +175,8 @@ class LSystemVisualizer(QMainWindow):
         direction = self.starting_direction
         stack = [] # initialize visualization variables.
         
-        for char in self.parsed: # mimic the behavior of the visualization by "walking" through the parsed L-System to find extreme coordinates. 
+        for code in self.parsed: # mimic the behavior of the visualization by "walking" through the parsed L-System to find extreme coordinates. 
+            char = chr(code) # the parsed system is a bytes-like object, so each item is a byte value.
             if char.isalpha() and char.isupper(): 
                 x += math.cos(math.radians(direction))
                 y -= math.sin(math.radians(direction)) 
@@ -129,12 +225,11 @@ class LSystemVisualizer(QMainWindow):
         """
         Initializes the starting point for the visualization.
 
-        The starting point is set to the origin (0, 0) and the stack, points, and current index are reset.
+        The starting point is set to the origin (0, 0) and the stack and current index are reset.
         """
         self.x = 0  # start at origin.
         self.y = 0
         self.stack = []
-        self.points = [(self.x, self.y)]
         self.current_index = 0
 
     def update_frame(self) -> None: 
@@ -143,31 +238,40 @@ class LSystemVisualizer(QMainWindow):
 
         This function is called repeatedly by the QTimer to incrementally build the visualization.
         It processes the next batch of characters in the parsed L-System string and updates the visualization accordingly.
+        Every line drawn in a batch goes into a single QPainterPath, so each frame adds one graphics item no matter how many segments it draws.
+        Consecutive draws share a heading, so they are merged into one line that is only added when a turn, push, pop or lowercase move ends it.
         If the end of the string is reached, the QTimer is stopped.
         """
         if self.current_index >= len(self.parsed): # stop the timer when the string has been fully parsed.
             self.timer.stop()
             return
         
+        start = self.trace.now() if self.trace else 0
+        first_index = self.current_index
         batch_size = 1000  # handle 1000 characters at a time.
+        batch_end = min(self.current_index + batch_size, len(self.parsed))
+        path = QPainterPath() # collect this batch's lines into one path.
+        path.moveTo(self.x, self.y)
+        drawn = False
+        pending = False # whether a straight run of draws has not been added to the path yet.
         
-        for _ in range(batch_size):
-            if self.current_index >= len(self.parsed):
-                self.timer.stop()
-                return
-                
-            old_x, old_y = self.x, self.y
-            char = self.parsed[self.current_index]
+        while self.current_index < batch_end:
+            char = chr(self.parsed[self.current_index])
+            drawing = char.isalpha() and char.isupper()
+
+            if pending and not drawing and (char.isalpha() or char in '+-[]'): # a state change ends the straight run.
+                path.lineTo(self.x, self.y)
+                pending = False
             
-            if char.isalpha() and char.isupper(): # for uppercase letters, move while drawing.
+            if drawing: # for uppercase letters, move while drawing.
                 self.x += math.cos(math.radians(self.starting_direction)) # move in the x direction at the starting angle. 
                 self.y -= math.sin(math.radians(self.starting_direction)) # move in the y direction at the starting angle. 
-                self.points.append((self.x, self.y)) # add the points.
-                line = self.scene.addLine(old_x, old_y, self.x, self.y, self.pen) # create a line between the old and new points.
-                self.path_items.append(line) # add the line to the path items.
+                pending = True # extend the straight run to the new point.
+                drawn = True
             elif char.isalpha(): # for lowercase letters, move without drawing.
                 self.x += math.cos(math.radians(self.starting_direction))
                 self.y -= math.sin(math.radians(self.starting_direction)) # simply add to the x and y coordinates. 
+                path.moveTo(self.x, self.y)
             elif char == '+': # turn left at turn angle
                 self.starting_direction += self.turn_angle
             elif char == '-': # turn right at turn angle
@@ -177,17 +281,31 @@ class LSystemVisualizer(QMainWindow):
             elif char == ']':
                 if self.stack: # remove the top stack frame
                     self.x, self.y, self.starting_direction = self.stack.pop()
-                    self.points.append((self.x, self.y))
+                    path.moveTo(self.x, self.y) # start a new subpath at the restored point.
                     
             self.current_index += 1 # continue to the next character.
 
+        if pending: # close the last straight run of the batch.
+            path.lineTo(self.x, self.y)
+
+        if drawn: # add the whole batch as a single item.
+            self.path_items.append(self.scene.addPath(path, self.pen))
+
+        if self.current_index >= len(self.parsed):
+            self.timer.stop()
+
+        if self.trace:
+            self.trace.span("update_frame", start, "symbols", batch_end - first_index)
+
     def visualize(self) -> None: 
         """
         Shows the QGraphicsView and starts the QTimer to animate the visualization at 1000 frames per second.
+        A tiled system is already complete, so it is shown without the animation.
         """
         self.show()
         self.view.fitInView(self.scene.sceneRect(), Qt.KeepAspectRatio)
-        self.timer.start(1)
+        if self.tile_layer is None:
+            self.timer.start(1)
 
         if hasattr(self, 'app') and not self.app.startingUp():
             return self.app.exec_()
\ No newline at end of file
@@ -0,0 +1,773 @@
+#include "batch.h"
+#include "length.h"
+#include "parser.h"
+#include "parallel.h"
+#include "stream.h"
+#include "turtle.h"
+#include "out_of_core.h"
+#include "render.h"
+#include "svg.h"
+#include "visualizer_config.h"
+#include "trace.h"
+#include "cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <pthread.h>
+
+typedef struct {
+    BatchJob* jobs;
+    int job_count;
+    int next;
+    pthread_mutex_t lock;
+} BatchQueue; // jobs shared by the worker threads, handed out in order
+
+typedef struct {
+    BatchJob* jobs;
+    int count;
+    int capacity;
+} BatchList; // growable list of the jobs read from argv and spec files
+
+/**
+ * @brief Prints the batch mode usage.
+ */
+static void print_usage() { // list every batch option
+    printf(
+        "Usage: lsystem [system options] [output options] ... [--spec FILE] [--jobs N] [--threads N]" "\n\n"
+        "Each system starts with --example or --axiom, and the options after it apply to it:" "\n"
+        "  --example N        use example N (1-10) from the library" "\n"
+        "  --axiom S          use a custom axiom; pair with --rule and --iterations" "\n"
+        "  --rule C=BODY      add a rule for character C, may be repeated" "\n"
+        "  --iterations N     number of iterations, overriding the example's" "\n"
+        "  --angle A          turn angle in degrees (default 90 for custom systems)" "\n"
+        "  --start D          starting direction in degrees (default 90 for custom systems)" "\n"
+        "  --render FILE      render to a PNG or PPM image" "\n"
+        "  --svg FILE         export as an SVG path" "\n"
+        "  --output FILE      write the parsed string to FILE, streamed to disk so it may exceed RAM" "\n"
+        "  --size N           image width and height, in pixels (default %d)" "\n"
+        "  --dedup            drop segments that retrace earlier ones before output" "\n"
+        "  --visualize        show the system in the GUI once every system is processed" "\n"
+        "  --stats            count the symbols by matrix exponentiation instead of expanding," "\n"
+        "                     so --iterations may be far beyond what memory allows" "\n\n"
+        "  --spec FILE        read more systems from FILE, one per line, written as the options" "\n"
+        "                     above without dashes, e.g. `example=3 iterations=5 render=out.png`" "\n"
+        "  --jobs N           process up to N systems at once (default: one per CPU)" "\n"
+        "  --threads N        expand --output and --visualize strings in memory on N threads" "\n"
+        "                     (0: one per CPU) instead of streaming them on one" "\n"
+        "  --trace FILE       write a Chrome trace of the run to FILE (or set %s)" "\n\n"
+        "Every system prints its length, draw and move counts, segment count, bounds and time." "\n",
+        RENDER_DEFAULT_SIZE, TRACE_ENV);
+}
+
+/**
+ * @brief Appends an empty job to a list.
+ *
+ * @param list The list to grow.
+ *
+ * @return The index of the new job, or -1 if allocation fails.
+ */
+static int add_job(BatchList* list) { // start a new job with its defaults
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 8;
+        BatchJob* jobs = realloc(list->jobs, (size_t)capacity * sizeof(BatchJob));
+
+        if (!jobs) {
+            return -1;
+        }
+
+        list->jobs = jobs;
+        list->capacity = capacity;
+    }
+
+    BatchJob* job = &list->jobs[list->count];
+    memset(job, 0, sizeof(BatchJob)); // an all-zero rule list ends before the first rule
+    job->size = RENDER_DEFAULT_SIZE;
+    job->turn_angle = 90.0f;
+    job->start_direction = 90.0f;
+
+    return list->count++;
+}
+
+/**
+ * @brief Checks that a string only holds the symbols the turtle understands.
+ *
+ * @param symbols The axiom or rule body.
+ *
+ * @return 1 if every character is a letter, '+', '-', '[' or ']', 0 otherwise.
+ */
+static int valid_symbols(const char* symbols) { // same alphabet as the interactive validation
+    for (size_t i = 0; symbols[i] != '\0'; i++) {
+        if (!isalpha((unsigned char)symbols[i]) && !strchr("+-[]", symbols[i])) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Reports whether a name is one of the batch options.
+ */
+static int known_option(const char* key) { // every option accepted by apply_option and run_batch
+    const char* options[] = {
+        "example", "axiom", "rule", "iterations", "angle", "start", "render", "svg", "output", "size", "dedup", "visualize", "stats", "spec", "jobs", "threads", "trace", "help"
+    };
+
+    for (size_t i = 0; i < sizeof(options) / sizeof(options[0]); i++) {
+        if (strcmp(key, options[i]) == 0) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Reports whether a batch option is followed by a value.
+ */
+static int option_takes_value(const char* key) { // options other than the flags take one value
+    return strcmp(key, "dedup") != 0 && strcmp(key, "visualize") != 0 && strcmp(key, "stats") != 0 && strcmp(key, "help") != 0;
+}
+
+/**
+ * @brief Parses a whole decimal integer within a range.
+ *
+ * @param text The option value.
+ * @param min The smallest value accepted.
+ * @param max The largest value accepted.
+ * @param value Receives the integer.
+ *
+ * @return 1 on success, 0 if the text is empty, has anything after the digits or is out of range.
+ */
+static int parse_int(const char* text, long min, long max, int* value) { // strict atoi
+    char* end;
+    errno = 0;
+    long parsed = strtol(text, &end, 10);
+
+    if (end == text || *end != '\0' || errno == ERANGE || parsed < min || parsed > max) {
+        return 0;
+    }
+
+    *value = (int)parsed;
+    return 1;
+}
+
+/**
+ * @brief Applies one option to a job.
+ *
+ * @param job The job to update.
+ * @param key The option name, without dashes.
+ * @param value The option value, or NULL for a flag.
+ * @param examples The example library.
+ * @param example_count The number of examples.
+ *
+ * @return 1 on success, 0 if the option is unknown or its value is invalid, after printing why.
+ */
+static int apply_option(BatchJob* job, const char* key, const char* value, const L_System* examples, int example_count) { // set one field of a job
+    if (strcmp(key, "example") == 0) {
+        int index;
+        if (!parse_int(value, 1, example_count, &index)) {
+            printf("ERROR: Example number must be between 1 and %d." "\n", example_count);
+            return 0;
+        }
+        index--;
+
+        job->system = examples[index];
+        job->has_system = 1;
+        snprintf(job->name, sizeof(job->name), "example %d", index + 1);
+    } else if (strcmp(key, "axiom") == 0) {
+        if (strlen(value) == 0 || strlen(value) >= SIZE || !valid_symbols(value)) {
+            printf("ERROR: Axiom must be 1 to %d letters or the symbols +, -, [, and ]." "\n", SIZE - 1);
+            return 0;
+        }
+
+        strcpy(job->system.axiom, value);
+        job->has_system = 1;
+        snprintf(job->name, sizeof(job->name), "axiom %s", value);
+    } else if (strcmp(key, "rule") == 0) {
+        if (strlen(value) < 2 || value[1] != '=' || !isalpha((unsigned char)value[0])
+            || strlen(value + 2) >= SIZE || !valid_symbols(value + 2)) {
+            printf("ERROR: Rule must look like C=BODY, with a body of up to %d letters or the symbols +, -, [, and ]." "\n", SIZE - 1);
+            return 0;
+        }
+        if (job->rule_count == SIZE - 1) {
+            printf("ERROR: A system can have at most %d rules." "\n", SIZE - 1);
+            return 0;
+        }
+
+        job->system.rules[job->rule_count].character = value[0];
+        strcpy(job->system.rules[job->rule_count].rule, value + 2);
+        job->rule_count++;
+    } else if (strcmp(key, "iterations") == 0) {
+        if (!parse_int(value, 0, INT_MAX, &job->iterations)) {
+            printf("ERROR: Iterations must be a positive integer." "\n");
+            return 0;
+        }
+        job->has_iterations = 1;
+    } else if (strcmp(key, "angle") == 0) {
+        job->turn_angle = (float)atof(value);
+        job->has_angle = 1;
+    } else if (strcmp(key, "start") == 0) {
+        job->start_direction = (float)atof(value);
+        job->has_start = 1;
+    } else if (strcmp(key, "render") == 0 || strcmp(key, "svg") == 0) {
+        if (strlen(value) >= BATCH_PATH_SIZE) {
+            printf("ERROR: Output path is too long." "\n");
+            return 0;
+        }
+
+        strcpy(strcmp(key, "svg") == 0 ? job->svg_path : job->render_path, value);
+    } else if (strcmp(key, "output") == 0) {
+        if (strlen(value) >= BATCH_PATH_SIZE) {
+            printf("ERROR: Output path is too long." "\n");
+            return 0;
+        }
+
+        strcpy(job->output_path, value);
+    } else if (strcmp(key, "size") == 0) {
+        if (!parse_int(value, 1, INT_MAX, &job->size)) {
+            printf("ERROR: Image size must be a positive integer." "\n");
+            return 0;
+        }
+    } else if (strcmp(key, "dedup") == 0) {
+        job->dedup = 1;
+    } else if (strcmp(key, "visualize") == 0) {
+        job->visualize = 1;
+    } else if (strcmp(key, "stats") == 0) {
+        job->analytic = 1;
+    } else {
+        printf("ERROR: Unknown option '%s'. Run with --help to list the options." "\n", key);
+        return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Checks that a job describes a whole system and applies its overrides.
+ *
+ * Custom systems need their iterations. Examples bring their own, which
+ * `--iterations`, `--angle` and `--start` override in any order.
+ *
+ * @param job The job to finish.
+ *
+ * @return 1 if the job is complete, 0 otherwise, after printing why.
+ */
+static int finish_job(BatchJob* job) { // merge overrides into the system
+    if (!job->has_system) {
+        printf("ERROR: Every system needs --example or --axiom." "\n");
+        return 0;
+    }
+
+    int custom = strncmp(job->name, "axiom", 5) == 0;
+    if (custom && !job->has_iterations) {
+        printf("ERROR: The system with %s needs --iterations." "\n", job->name);
+        return 0;
+    }
+    if (!custom && job->rule_count > 0) {
+        printf("ERROR: Rules can only be given for a custom --axiom, not for %s." "\n", job->name);
+        return 0;
+    }
+
+    if (job->has_iterations || custom) {
+        job->system.iterations = job->iterations;
+    }
+    if (job->has_angle || custom) {
+        job->system.turn_angle = job->turn_angle;
+    }
+    if (job->has_start || custom) {
+        job->system.start_direction = job->start_direction;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Reads the systems in a spec file into a job list.
+ *
+ * Every non-empty line that does not start with '#' is one system, written as the
+ * batch options separated by spaces, each as `key=value` or just `key` for a flag.
+ * Leading dashes are allowed, so a line can also be pasted from a command line.
+ *
+ * @param path The spec file.
+ * @param list The list to add the systems to.
+ * @param examples The example library.
+ * @param example_count The number of examples.
+ *
+ * @return 1 on success, 0 if the file cannot be read or a line is invalid.
+ */
+static int read_spec(const char* path, BatchList* list, const L_System* examples, int example_count) { // one system per line
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        printf("ERROR: Unable to read spec file %s" "\n", path);
+        return 0;
+    }
+
+    char line[BATCH_LINE_SIZE];
+    int line_number = 0;
+    int ok = 1;
+
+    while (ok && fgets(line, sizeof(line), file)) {
+        line_number++;
+
+        char* token = strtok(line, " \t\r\n");
+        if (!token || token[0] == '#') { // blank line or comment
+            continue;
+        }
+
+        int index = add_job(list);
+        if (index < 0) {
+            ok = 0;
+            break;
+        }
+
+        for (; token && ok; token = strtok(NULL, " \t\r\n")) {
+            while (*token == '-') {
+                token++;
+            }
+
+            char* value = strchr(token, '=');
+            if (value) {
+                *value++ = '\0'; // split at the first '=', so rule=F=FF keeps F=FF as the value
+            }
+
+            if (option_takes_value(token) && !value) {
+                printf("ERROR: Option '%s' needs a value." "\n", token);
+                ok = 0;
+            } else {
+                ok = apply_option(&list->jobs[index], token, value, examples, example_count);
+            }
+        }
+
+        if (ok) {
+            ok = finish_job(&list->jobs[index]);
+        }
+        if (!ok) {
+            printf("ERROR: In %s on line %d." "\n", path, line_number);
+        }
+    }
+
+    fclose(file);
+    return ok;
+}
+
+static int expand_threads = 0; // threads for parser_parallel() from --threads, or 0 to stream with one
+
+/**
+ * @brief Writes a system's parsed string to a file after expanding it in memory with `parser_parallel()`.
+ *
+ * @param sys The L-System to expand.
+ * @param path The file to write.
+ *
+ * @return 1 on success, 0 if the string does not fit in memory or the file cannot be written.
+ */
+static int write_parallel(L_System* sys, const char* path) { // --output with --threads
+    char* parsed = parser_parallel(sys->axiom, sys->rules, sys->iterations, expand_threads);
+    if (!parsed) {
+        return 0;
+    }
+
+    size_t length = strlen(parsed);
+    FILE* file = fopen(path, "wb");
+    int ok = file && fwrite(parsed, 1, length, file) == length;
+    if (file) {
+        ok = fclose(file) == 0 && ok;
+    }
+
+    buffer_release(parsed);
+    return ok;
+}
+
+/**
+ * @brief Turtle sink that only counts segments, for the stats pass.
+ */
+static int count_segment(const float* segment, int continues, void* context) { // tally without storing
+    (void)segment;
+    (void)continues;
+    (*(size_t*)context)++;
+    return 1;
+}
+
+/**
+ * @brief Copies the turtle totals of a job's render or SVG export into its stats.
+ */
+static void take_totals(BatchJob* job, const TurtleTotals* totals) { // draws, moves, segments and bounds
+    job->draw_count = totals->draw_count;
+    job->move_count = totals->move_count;
+    job->segment_count = totals->segment_count;
+    job->bounds = totals->bounds;
+}
+
+/**
+ * @brief Collects a job's stats by streaming its expansion through a counting turtle.
+ *
+ * The system is streamed straight into the turtle, so no job ever holds its parsed string.
+ * Only used for jobs without a render or SVG export, whose turtles report the same stats.
+ *
+ * @param job The job to count. Any error is stored in it.
+ *
+ * @return 1 on success, 0 on failure.
+ */
+static int stream_stats(BatchJob* job) { // draws, moves, segments and bounds
+    L_System* sys = &job->system;
+
+    Turtle turtle;
+    LStream stream;
+    turtle_init(&turtle, sys->turn_angle, sys->start_direction);
+    turtle.sink = count_segment;
+    turtle.sink_context = &job->segment_count;
+
+    if (!stream_init(&stream, sys->axiom, sys->rules, sys->iterations)) {
+        snprintf(job->error, sizeof(job->error), "Unable to start the expansion.");
+        return 0;
+    }
+
+    double span = trace_begin();
+    int ok = stream_drain(&stream, turtle_consume, &turtle) && turtle_finish(&turtle); // interpret while expanding
+    stream_free(&stream);
+    trace_end("stream_stats", span, "segments", (double)job->segment_count);
+
+    TurtleTotals totals;
+    turtle_totals(&turtle, job->segment_count, &totals);
+    take_totals(job, &totals);
+    turtle_free(&turtle);
+
+    if (!ok) {
+        snprintf(job->error, sizeof(job->error), "Ran out of memory while interpreting.");
+    }
+
+    return ok;
+}
+
+/**
+ * @brief Processes one job: collects its stats, then writes its outputs.
+ *
+ * The length comes from `calculate_parsed_length()`, and with `--stats` every count
+ * comes from `calculate_stats()`, neither of which expands the system. The draws, moves,
+ * segments and bounds are reported by the turtle of the render or SVG export, so each
+ * output expands the system once; only a job with neither runs `stream_stats()` for them.
+ *
+ * @param job The job to process. Its results and any error are stored in it.
+ */
+static void process_job(BatchJob* job) { // stats, then outputs
+    L_System* sys = &job->system;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    job->ok = 0;
+    if (job->analytic) {
+        double span = trace_begin();
+        int counted = calculate_stats(sys->axiom, sys->rules, (unsigned long long)sys->iterations, &job->stats);
+        trace_end("analytic_stats", span, NULL, 0);
+        if (!counted) {
+            snprintf(job->error, sizeof(job->error), "Ran out of memory while counting.");
+            return;
+        }
+    } else if (!calculate_parsed_length(sys->axiom, sys->rules, sys->iterations, &job->length)) {
+        snprintf(job->error, sizeof(job->error), "The parsed system is too large to count.");
+        return;
+    } else if (!job->render_path[0] && !job->svg_path[0] && !stream_stats(job)) {
+        return;
+    }
+
+    TurtleTotals totals;
+    if (job->render_path[0] && !render_system(sys, job->size, job->size, job->render_path, job->dedup, &job->render_removed, &totals)) {
+        snprintf(job->error, sizeof(job->error), "Unable to export to %.80s", job->render_path);
+        return;
+    }
+    if (job->svg_path[0] && !export_svg(sys, job->svg_path, job->dedup, &job->svg_removed, &totals)) {
+        snprintf(job->error, sizeof(job->error), "Unable to export to %.80s", job->svg_path);
+        return;
+    }
+    if (!job->analytic && (job->render_path[0] || job->svg_path[0])) {
+        take_totals(job, &totals);
+    }
+    if (job->output_path[0]) {
+        int written = expand_threads > 0 ? write_parallel(sys, job->output_path) : parser_to_file(sys->axiom, sys->rules, sys->iterations, job->output_path, NULL);
+        if (!written) {
+            snprintf(job->error, sizeof(job->error), "Unable to write to %.80s", job->output_path);
+            return;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    job->seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    job->ok = 1;
+}
+
+/**
+ * @brief Worker thread body that takes jobs off the queue until it is empty.
+ */
+static void* batch_worker(void* context) { // process queued jobs
+    BatchQueue* queue = context;
+
+    while (1) {
+        pthread_mutex_lock(&queue->lock);
+        int index = queue->next++;
+        pthread_mutex_unlock(&queue->lock);
+
+        if (index >= queue->job_count) {
+            return NULL;
+        }
+
+        double span = trace_begin();
+        process_job(&queue->jobs[index]);
+        trace_end(queue->jobs[index].name, span, "length", (double)queue->jobs[index].length);
+    }
+}
+
+/**
+ * @brief Prints the line of a job counted with `--stats`, then the count of each of its symbols.
+ *
+ * The time is marked "(not expanded)" only when the job has no output that expands the system.
+ */
+static void print_analytic_stats(int number, const BatchJob* job) { // one system's analytic counts
+    const SystemStats* stats = &job->stats;
+    char length[STAT_COUNT_DIGITS], draws[STAT_COUNT_DIGITS], moves[STAT_COUNT_DIGITS], pushes[STAT_COUNT_DIGITS];
+
+    format_stat_count(stats->length, length);
+    format_stat_count(stats->draws, draws);
+    format_stat_count(stats->moves, moves);
+    format_stat_count(stats->pushes, pushes);
+
+    printf("[%d] %s: %d iterations, length %s, %s draws, %s moves, %s brackets, ",
+        number, job->name, job->system.iterations, length, draws, moves, pushes);
+    if (stats->max_depth >= 0) {
+        printf("deepest nesting %lld, ", stats->max_depth);
+    }
+    int expanded = job->render_path[0] || job->svg_path[0] || job->output_path[0] || job->visualize;
+    printf("%.6f s%s" "\n", job->seconds, expanded ? "" : " (not expanded)"); // outputs still expand the system
+
+    printf("    counts");
+    for (int i = 0; i < stats->size; i++) {
+        char count[STAT_COUNT_DIGITS];
+        format_stat_count(stats->counts[i], count);
+        printf(" %c=%s", stats->symbols[i], count);
+    }
+    printf("\n");
+}
+
+/**
+ * @brief Runs the program non-interactively from command line options.
+ *
+ * The options describe one or more systems, each with its own outputs, and spec
+ * files add more. Every system is expanded, optionally rendered and exported, and
+ * its stats are printed, without any menus. Independent systems are processed by a
+ * pool of worker threads, so their expansion and output overlap. With `--threads`,
+ * strings that are written whole or visualized are expanded in memory by
+ * `parser_parallel()`, so one large system also uses several cores. Python is only
+ * started if a system asks for `--visualize`, after every other system is done.
+ *
+ * The older `--render <example number> <file>` and `--svg <example number> <file>`
+ * forms are still accepted, with or without a trailing `--dedup`.
+ *
+ * @param argc The number of command line arguments.
+ * @param argv The command line arguments.
+ * @param examples The example library.
+ * @param example_count The number of examples.
+ *
+ * @return 0 if every system succeeded, 1 otherwise.
+ */
+int run_batch(int argc, char* argv[], const L_System* examples, int example_count) { // batch mode entry point
+    BatchList list = {NULL, 0, 0};
+    int current = -1; // the job the command line options are being applied to
+    int threads = 0;
+    int ok = 1;
+
+    for (int i = 1; i < argc && ok; i++) {
+        if (strncmp(argv[i], "--", 2) != 0) {
+            printf("ERROR: Unexpected argument '%s'. Run with --help to list the options." "\n", argv[i]);
+            ok = 0;
+            break;
+        }
+
+        const char* key = argv[i] + 2;
+        if (!known_option(key)) {
+            printf("ERROR: Unknown option '%s'. Run with --help to list the options." "\n", argv[i]);
+            ok = 0;
+            break;
+        }
+
+        if (strcmp(key, "help") == 0) {
+            print_usage();
+            free(list.jobs);
+            return 0;
+        }
+
+        if (option_takes_value(key) && i + 1 >= argc) {
+            printf("ERROR: Option '--%s' needs a value." "\n", key);
+            ok = 0;
+            break;
+        }
+
+        if (strcmp(key, "jobs") == 0 || strcmp(key, "threads") == 0) {
+            int count;
+            if (!parse_int(argv[++i], 0, INT_MAX, &count)) {
+                printf("ERROR: Option '--%s' needs a whole number of threads, or 0 for one per CPU." "\n", key);
+                ok = 0;
+            } else if (strcmp(key, "jobs") == 0) {
+                threads = count;
+            } else {
+                expand_threads = resolve_thread_count(count);
+            }
+        } else if (strcmp(key, "trace") == 0) {
+            const char* path = argv[++i];
+            if (!trace_enabled && !trace_start(path)) { // a trace started from LSYSTEM_TRACE takes precedence
+                printf("ERROR: Unable to start a trace." "\n");
+                ok = 0;
+            }
+        } else if (strcmp(key, "spec") == 0) {
+            ok = read_spec(argv[++i], &list, examples, example_count);
+            current = -1; // options after a spec file start a new system
+        } else {
+            int legacy = (strcmp(key, "render") == 0 || strcmp(key, "svg") == 0) && i + 2 < argc
+                && strspn(argv[i + 1], "0123456789") == strlen(argv[i + 1]) && strncmp(argv[i + 2], "--", 2) != 0;
+            int starts_system = legacy || strcmp(key, "example") == 0 || strcmp(key, "axiom") == 0;
+
+            if (current < 0 || (starts_system && list.jobs[current].has_system)) { // begin the next system
+                if (current >= 0) {
+                    ok = finish_job(&list.jobs[current]);
+                }
+
+                current = add_job(&list);
+                ok = ok && current >= 0;
+            }
+
+            if (ok && legacy) { // --render <example number> <file>
+                ok = apply_option(&list.jobs[current], "example", argv[i + 1], examples, example_count);
+                i++;
+            }
+
+            if (ok) {
+                const char* value = option_takes_value(key) ? argv[++i] : NULL;
+                ok = apply_option(&list.jobs[current], key, value, examples, example_count);
+            }
+        }
+    }
+
+    if (ok && current >= 0) {
+        ok = finish_job(&list.jobs[current]);
+    }
+    if (ok && list.count == 0) {
+        printf("ERROR: No systems given. Run with --help to list the options." "\n");
+        ok = 0;
+    }
+    if (!ok) {
+        free(list.jobs);
+        return 1;
+    }
+
+    BatchQueue queue;
+    queue.jobs = list.jobs;
+    queue.job_count = list.count;
+    queue.next = 0;
+    pthread_mutex_init(&queue.lock, NULL);
+
+    int count = resolve_thread_count(threads);
+    if (count > list.count) {
+        count = list.count;
+    }
+
+    pthread_t workers[count];
+    int started[count];
+
+    for (int t = 1; t < count; t++) {
+        started[t] = pthread_create(&workers[t], NULL, batch_worker, &queue) == 0;
+    }
+    batch_worker(&queue); // the main thread works too, and finishes the queue if no thread could start
+
+    for (int t = 1; t < count; t++) {
+        if (started[t]) {
+            pthread_join(workers[t], NULL);
+        }
+    }
+    pthread_mutex_destroy(&queue.lock);
+
+    int failures = 0;
+    _Bool python_ready = 0;
+
+    for (int j = 0; j < list.count; j++) { // report in the order the systems were given
+        BatchJob* job = &list.jobs[j];
+
+        if (!job->ok) {
+            printf("[%d] %s: ERROR: %s" "\n", j + 1, job->name, job->error);
+            failures++;
+            continue;
+        }
+
+        if (job->analytic) {
+            print_analytic_stats(j + 1, job);
+        } else {
+            printf("[%d] %s: %d iterations, length %zu, %zu draws in %zu segments, %zu moves, bounds x [%.3f, %.3f] y [%.3f, %.3f], %.3f s" "\n",
+                j + 1, job->name, job->system.iterations, job->length, job->draw_count, job->segment_count, job->move_count,
+                job->bounds.min_x, job->bounds.max_x, job->bounds.min_y, job->bounds.max_y, job->seconds);
+        }
+
+        if (job->render_path[0]) {
+            printf("    wrote %s" "\n", job->render_path);
+            if (job->dedup) {
+                printf("    removed %zu duplicate segments" "\n", job->render_removed);
+            }
+        }
+        if (job->svg_path[0]) {
+            printf("    wrote %s" "\n", job->svg_path);
+            if (job->dedup) {
+                printf("    removed %zu duplicate segments" "\n", job->svg_removed);
+            }
+        }
+        if (job->output_path[0]) {
+            printf("    wrote %s" "\n", job->output_path);
+        }
+    }
+
+    for (int j = 0; j < list.count; j++) { // the GUI runs on the main thread, one system at a time
+        BatchJob* job = &list.jobs[j];
+        if (!job->ok || !job->visualize) {
+            continue;
+        }
+
+        L_System* sys = &job->system;
+        CacheEntry parsed;
+        char* expanded = NULL; // from parser_parallel(), on a cache miss with --threads
+        int parsed_ok;
+        if (expand_threads > 0) {
+            parsed_ok = cache_load_string(sys, &parsed);
+            if (!parsed_ok && (expanded = parser_parallel(sys->axiom, sys->rules, sys->iterations, expand_threads))) {
+                parsed.string = expanded;
+                parsed.length = strlen(expanded);
+                cache_store_string(sys, parsed.string, parsed.length);
+                parsed_ok = 1;
+            }
+        } else {
+            parsed_ok = cache_parse(sys, &parsed);
+        }
+        if (!parsed_ok) {
+            printf("[%d] %s: ERROR: The parsed system is too large to store." "\n", j + 1, job->name);
+            failures++;
+            continue;
+        }
+
+        if (!python_ready) { // setup python environment on first use
+            initialize_python();
+            python_ready = 1;
+        }
+
+        Bounds bounds;
+        int has_bounds = calculate_bounds(sys->axiom, sys->rules, sys->iterations, sys->turn_angle, sys->start_direction, &bounds);
+        visualize(parsed.string, sys->turn_angle, sys->start_direction, has_bounds ? &bounds : NULL);
+        cache_entry_free(&parsed);
+        buffer_release(expanded);
+    }
+
+    if (python_ready) {
+        finalize_python();
+    }
+
+    free(list.jobs);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,311 @@
+#include "bounds.h"
+#include "rule_table.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string.h>
+#include <math.h>
+
+typedef struct {
+    const RuleTable* table;
+    int headings;
+    double* step_x;
+    double* step_y;
+    int* rule_index;
+    TurtleSummary* memo;
+} BoundsEngine; // memo[(depth * rule_count + rule) * headings + heading]
+
+typedef struct {
+    double x, y;
+    int heading;
+} BoundsState; // turtle state relative to the start of the expansion being summarized
+
+/**
+ * @brief Counts the distinct headings a turtle can face with a given turn angle.
+ *
+ * When the turn angle divides 360, every heading the turtle can reach is the starting
+ * direction plus a whole number of turns, modulo 360, so there are `360 / turn_angle`
+ * heading classes. A turn angle of 0 leaves a single class.
+ *
+ * @param turn_angle The angle, in degrees, turned by '+' and '-'.
+ *
+ * @return The number of heading classes, or 0 if the angle does not divide 360 or needs
+ * more than `BOUNDS_MAX_HEADINGS` classes.
+ */
+int count_heading_classes(double turn_angle) { // headings reachable with this turn angle
+    double angle = fabs(fmod(turn_angle, 360.0));
+
+    if (angle < 1e-9) {
+        return 1;
+    }
+
+    double classes = 360.0 / angle;
+    double rounded = floor(classes + 0.5);
+
+    if (fabs(classes - rounded) > 1e-6 || rounded > BOUNDS_MAX_HEADINGS) {
+        return 0;
+    }
+
+    return (int)rounded;
+}
+
+/**
+ * @brief Widens a box to include another box shifted by an offset.
+ *
+ * @param box The box to widen.
+ * @param other The box to include. An empty box (min > max) changes nothing.
+ * @param x The x offset of `other`.
+ * @param y The y offset of `other`.
+ */
+static void merge_box(Bounds* box, const Bounds* other, double x, double y) { // union with a translated box
+    if (other->min_x > other->max_x) {
+        return;
+    }
+
+    if (other->min_x + x < box->min_x) box->min_x = other->min_x + x;
+    if (other->max_x + x > box->max_x) box->max_x = other->max_x + x;
+    if (other->min_y + y < box->min_y) box->min_y = other->min_y + y;
+    if (other->max_y + y > box->max_y) box->max_y = other->max_y + y;
+}
+
+/**
+ * @brief Widens a box to include a point.
+ */
+static void include_point(Bounds* box, double x, double y) { // union with a point
+    Bounds point = {x, x, y, y};
+    merge_box(box, &point, 0, 0);
+}
+
+/**
+ * @brief Summarizes a symbol that is drawn as it is, with no expansion left.
+ *
+ * @param engine The bounds engine.
+ * @param c The symbol. Brackets are handled by `apply_body()` and never reach here.
+ * @param heading The heading class the symbol is read at.
+ *
+ * @return The effect of the symbol on the turtle.
+ */
+static TurtleSummary leaf_summary(const BoundsEngine* engine, unsigned char c, int heading) { // effect of one final symbol
+    TurtleSummary summary = {0, 0, 0, {INFINITY, -INFINITY, INFINITY, -INFINITY}};
+
+    if (isupper(c)) { // move forward while drawing, the endpoint counts toward the bounds
+        summary.dx = engine->step_x[heading];
+        summary.dy = engine->step_y[heading];
+        include_point(&summary.box, summary.dx, summary.dy);
+    } else if (islower(c)) { // move forward without drawing
+        summary.dx = engine->step_x[heading];
+        summary.dy = engine->step_y[heading];
+    } else if (c == '+') {
+        summary.turn = 1;
+    } else if (c == '-') {
+        summary.turn = engine->headings - 1;
+    }
+
+    return summary;
+}
+
+/**
+ * @brief Looks up the summary of a symbol with some iterations left at some heading.
+ */
+static const TurtleSummary* lookup_summary(const BoundsEngine* engine, unsigned char c, int depth, int heading) { // memo lookup
+    size_t rule_count = (size_t)engine->table->rule_count;
+    size_t index = ((size_t)depth * rule_count + engine->rule_index[c]) * engine->headings + heading;
+    return &engine->memo[index];
+}
+
+/**
+ * @brief Runs a turtle over a string of symbols, each expanded to a known depth.
+ *
+ * Symbols with a rule and depth left are applied through their memoized summary;
+ * everything else is a leaf. Brackets save and restore the relative state on a local
+ * stack, and a restored position counts toward the bounds, as in `set_boundaries()`.
+ * A ']' with nothing to restore is ignored.
+ *
+ * @param engine The bounds engine.
+ * @param body The symbols to run.
+ * @param length The number of symbols.
+ * @param depth The number of iterations left to apply to each symbol.
+ * @param state The turtle state, updated in place.
+ * @param box The box to widen with every counted point, relative to the same origin as `state`.
+ *
+ * @return 1 on success, 0 if allocation fails.
+ */
+static int apply_body(const BoundsEngine* engine, const char* body, size_t length, int depth, BoundsState* state, Bounds* box) { // run one body
+    BoundsState saved[64];
+    BoundsState* stack = saved;
+    size_t stack_size = 0;
+    size_t stack_capacity = 64;
+
+    for (size_t j = 0; j < length; j++) {
+        unsigned char c = (unsigned char)body[j];
+        int expands = depth > 0 && engine->table->has_rule[c];
+
+        if (!expands && c == '[') { // save state to stack
+            if (stack_size == stack_capacity) {
+                BoundsState* grown = malloc(stack_capacity * 2 * sizeof(BoundsState));
+                if (!grown) {
+                    if (stack != saved) free(stack);
+                    return 0;
+                }
+
+                memcpy(grown, stack, stack_size * sizeof(BoundsState));
+                if (stack != saved) free(stack);
+                stack = grown;
+                stack_capacity *= 2;
+            }
+
+            stack[stack_size++] = *state;
+        } else if (!expands && c == ']') { // restore state from stack
+            if (stack_size > 0) {
+                *state = stack[--stack_size];
+                include_point(box, state->x, state->y);
+            }
+        } else {
+            TurtleSummary leaf;
+            const TurtleSummary* summary = expands ? lookup_summary(engine, c, depth, state->heading) : &leaf;
+
+            if (!expands) {
+                leaf = leaf_summary(engine, c, state->heading);
+            }
+
+            merge_box(box, &summary->box, state->x, state->y);
+            state->x += summary->dx;
+            state->y += summary->dy;
+            state->heading = (state->heading + summary->turn) % engine->headings;
+        }
+    }
+
+    if (stack != saved) {
+        free(stack);
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Checks that a rule body saves and restores state in matching pairs.
+ */
+static int balanced(const char* body, size_t length) { // every ']' closes a '[' of the same body
+    int depth = 0;
+
+    for (size_t j = 0; j < length; j++) {
+        if (body[j] == '[') depth++;
+        if (body[j] == ']' && --depth < 0) return 0;
+    }
+
+    return depth == 0;
+}
+
+/**
+ * @brief Calculates the exact drawing bounds of a generation without expanding it.
+ *
+ * When the turn angle divides 360, a symbol with d iterations left always has the same
+ * effect on a turtle that starts it facing the same heading class: the same net
+ * displacement, the same net turn and the same bounding box relative to its start.
+ * This function memoizes that summary for every (symbol, depth, heading class) and
+ * builds each depth from the one below it, so the cost is
+ * O(rules x iterations x headings x rule length) instead of the length of the string.
+ * The result matches `set_boundaries()`: the box starts at the origin and grows with
+ * every drawn endpoint and every restored position.
+ *
+ * Summaries only compose when every rule body has matching brackets, since a body that
+ * restores state saved by its parent would need that parent's state. Systems with
+ * unmatched brackets in a rule, a rule for a bracket, or a turn angle that does not
+ * divide 360 are rejected, and the caller should walk the string with the turtle
+ * interpreter instead. Brackets in the axiom are always fine.
+ *
+ * @param axiom The axiom string.
+ * @param rules The set of rules to apply.
+ * @param iterations The number of iterations to apply the rules.
+ * @param turn_angle The angle, in degrees, turned by '+' and '-'.
+ * @param start_direction The starting heading, in degrees.
+ * @param bounds A pointer that receives the bounds.
+ *
+ * @return 1 on success, 0 if the system cannot be memoized or allocation fails.
+ */
+int calculate_bounds(const char* axiom, Rule rules[], int iterations, double turn_angle, double start_direction, Bounds* bounds) { // bounds of a generation from memoized summaries
+    int headings = count_heading_classes(turn_angle);
+    if (headings == 0 || iterations < 0) {
+        return 0;
+    }
+
+    RuleTable table;
+    if (!compile_rules(&table, rules)) {
+        return 0;
+    }
+
+    if (table.has_rule['['] || table.has_rule[']']) {
+        free_rule_table(&table);
+        return 0;
+    }
+
+    for (int k = 0; k < table.rule_count; k++) { // summaries only compose over balanced bodies
+        unsigned char c = table.rule_symbols[k];
+        if (!balanced(table.expansion[c], table.length[c])) {
+            free_rule_table(&table);
+            return 0;
+        }
+    }
+
+    BoundsEngine engine;
+    int rule_index[256];
+    size_t rule_count = (size_t)table.rule_count;
+
+    engine.table = &table;
+    engine.headings = headings;
+    engine.rule_index = rule_index;
+    engine.step_x = malloc((size_t)headings * sizeof(double));
+    engine.step_y = malloc((size_t)headings * sizeof(double));
+    engine.memo = malloc(((size_t)iterations + 1) * (rule_count > 0 ? rule_count : 1) * headings * sizeof(TurtleSummary));
+
+    int ok = engine.step_x && engine.step_y && engine.memo;
+
+    for (int h = 0; ok && h < headings; h++) { // unit step of every heading class
+        double radians = (start_direction + h * turn_angle) * M_PI / 180.0;
+        engine.step_x[h] = cos(radians);
+        engine.step_y[h] = -sin(radians); // screen coordinates, y grows downward
+    }
+
+    for (int k = 0; k < table.rule_count; k++) {
+        rule_index[table.rule_symbols[k]] = k;
+    }
+
+    for (int depth = 0; ok && depth <= iterations; depth++) { // fill the memo one depth at a time
+        for (size_t k = 0; ok && k < rule_count; k++) {
+            unsigned char c = table.rule_symbols[k];
+
+            for (int h = 0; ok && h < headings; h++) {
+                TurtleSummary* summary = &engine.memo[((size_t)depth * rule_count + k) * headings + h];
+
+                if (depth == 0) { // no iterations left, the symbol is drawn as it is
+                    *summary = leaf_summary(&engine, c, h);
+                    continue;
+                }
+
+                BoundsState state = {0, 0, h};
+                Bounds box = {INFINITY, -INFINITY, INFINITY, -INFINITY};
+                ok = apply_body(&engine, table.expansion[c], table.length[c], depth - 1, &state, &box);
+
+                summary->dx = state.x;
+                summary->dy = state.y;
+                summary->turn = (state.heading - h + headings) % headings;
+                summary->box = box;
+            }
+        }
+    }
+
+    if (ok) { // run the axiom at full depth from the origin, which is always in the bounds
+        BoundsState state = {0, 0, 0};
+        Bounds box = {0, 0, 0, 0};
+        ok = apply_body(&engine, axiom, strlen(axiom), iterations, &state, &box);
+        *bounds = box;
+    }
+
+    free(engine.step_x);
+    free(engine.step_y);
+    free(engine.memo);
+    free_rule_table(&table);
+
+    return ok;
+}
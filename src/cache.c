@@ -0,0 +1,437 @@
+#include "cache.h"
+#include "parser.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CACHE_MAGIC "LSYSCACH"
+#define CACHE_STRING 1 // a parsed string, null-terminated
+#define CACHE_GEOMETRY 2 // turtle segments, with their bounds and step counts
+#define CACHE_DATA_OFFSET ((sizeof(CacheHeader) + 63) / 64 * 64) // data starts on a 64-byte boundary after the header
+
+int cache_enabled = 0;
+
+static char cache_dir[CACHE_PATH_SIZE - 64]; // leaves room in a path for the file name
+static unsigned long long cache_limit = CACHE_DEFAULT_LIMIT;
+static size_t cache_hits = 0; // hits so far, sampled as a trace counter
+
+typedef struct {
+    char name[32];
+    off_t size;
+    double used;
+} CacheFile; // one entry found while enforcing the size limit
+
+/**
+ * @brief Creates a directory, succeeding if it already exists.
+ */
+static int make_directory(const char* path) { // mkdir that tolerates EEXIST
+    return mkdir(path, 0755) == 0 || errno == EEXIST;
+}
+
+/**
+ * @brief Opens a cache directory, creating it if needed, and enables the cache.
+ *
+ * @param dir The directory to keep cache files in. Its parent must exist.
+ * @param limit The most bytes of cache files to keep; the least recently used are removed beyond it.
+ *
+ * @return 1 on success, 0 if the directory cannot be created or the path is too long.
+ */
+int cache_open(const char* dir, unsigned long long limit) { // enable the cache
+    if (strlen(dir) >= CACHE_PATH_SIZE - 64 || !make_directory(dir)) { // leave room for file names
+        return 0;
+    }
+
+    strcpy(cache_dir, dir);
+    cache_limit = limit;
+    cache_enabled = 1;
+
+    return 1;
+}
+
+/**
+ * @brief Opens the cache directory named by the environment.
+ *
+ * The cache is off unless `LSYSTEM_CACHE` names a directory, so nothing is written
+ * outside the current run without asking; "off" is accepted and keeps it disabled.
+ * `LSYSTEM_CACHE_LIMIT` sets the size limit in bytes, 1 GiB by default.
+ *
+ * @return 1 if the cache is enabled, 0 otherwise.
+ */
+int cache_open_from_env() { // enable the cache only when asked to
+    const char* dir = getenv(CACHE_ENV);
+    const char* limit_text = getenv(CACHE_LIMIT_ENV);
+    unsigned long long limit = limit_text ? strtoull(limit_text, NULL, 10) : CACHE_DEFAULT_LIMIT;
+
+    if (!dir || dir[0] == '\0' || strcmp(dir, "off") == 0) {
+        return 0;
+    }
+
+    return cache_open(dir, limit);
+}
+
+/**
+ * @brief Writes the key text of a system, which names everything its result depends on.
+ *
+ * The key is the axiom, every rule in order, and the iterations; geometry keys add the
+ * turn angle and start direction, written exactly as hexadecimal floats.
+ *
+ * @return 1 on success, 0 if the key does not fit in `CACHE_KEY_SIZE`.
+ */
+static int make_key(const L_System* sys, int kind, char* key) { // canonical text of a system
+    size_t used = (size_t)snprintf(key, CACHE_KEY_SIZE, "axiom=%s;", sys->axiom);
+
+    for (int i = 0; i < SIZE && sys->rules[i].character != '\0' && used < CACHE_KEY_SIZE; i++) {
+        used += (size_t)snprintf(key + used, CACHE_KEY_SIZE - used, "%c=%s;", sys->rules[i].character, sys->rules[i].rule);
+    }
+    if (used < CACHE_KEY_SIZE) {
+        used += (size_t)snprintf(key + used, CACHE_KEY_SIZE - used, "iterations=%d", sys->iterations);
+    }
+    if (used < CACHE_KEY_SIZE && kind == CACHE_GEOMETRY) {
+        used += (size_t)snprintf(key + used, CACHE_KEY_SIZE - used, ";angle=%a;start=%a", (double)sys->turn_angle, (double)sys->start_direction);
+    }
+
+    return used < CACHE_KEY_SIZE;
+}
+
+/**
+ * @brief Hashes key text with 64-bit FNV-1a.
+ */
+static uint64_t hash_key(const char* key) { // content address of an entry
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (size_t i = 0; key[i] != '\0'; i++) {
+        hash ^= (unsigned char)key[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Builds the path of the cache file for a hash and kind.
+ */
+static void entry_path(uint64_t hash, int kind, char* path) { // <dir>/<hash>.str or .geo
+    snprintf(path, CACHE_PATH_SIZE, "%s/%016llx.%s", cache_dir, (unsigned long long)hash, kind == CACHE_STRING ? "str" : "geo");
+}
+
+/**
+ * @brief Maps a cache file read-only and checks that it holds the expected entry.
+ *
+ * A hit is marked as recently used by updating the file's modification time, which the
+ * size limit evicts by.
+ *
+ * @return 1 on a hit, 0 if there is no valid entry for the key.
+ */
+static int load_entry(const L_System* sys, int kind, CacheEntry* entry) { // map and validate one file
+    char key[CACHE_KEY_SIZE];
+    char path[CACHE_PATH_SIZE];
+
+    memset(entry, 0, sizeof(CacheEntry));
+    if (!cache_enabled || !make_key(sys, kind, key)) {
+        return 0;
+    }
+
+    uint64_t hash = hash_key(key);
+    entry_path(hash, kind, path);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < CACHE_DATA_OFFSET) {
+        close(fd);
+        return 0;
+    }
+
+    size_t size = (size_t)info.st_size;
+    void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return 0;
+    }
+
+    const CacheHeader* header = map;
+    size_t data_size = kind == CACHE_STRING ? header->count + 1 : header->count * 4 * sizeof(float);
+    int valid = memcmp(header->magic, CACHE_MAGIC, 8) == 0 && header->version == CACHE_VERSION
+        && header->kind == (uint32_t)kind && header->hash == hash && strncmp(header->key, key, CACHE_KEY_SIZE) == 0
+        && header->count <= size && size == CACHE_DATA_OFFSET + data_size;
+
+    if (!valid) {
+        munmap(map, size);
+        close(fd);
+        return 0;
+    }
+
+    futimens(fd, NULL); // most recently used
+    close(fd);
+    trace_counter("cache_hits", (double)__atomic_add_fetch(&cache_hits, 1, __ATOMIC_RELAXED));
+
+    entry->map = map;
+    entry->map_size = size;
+    if (kind == CACHE_STRING) {
+        entry->string = (const char*)map + CACHE_DATA_OFFSET;
+        entry->length = header->count;
+    } else {
+        entry->segments = (const float*)((const char*)map + CACHE_DATA_OFFSET);
+        entry->segment_count = header->count;
+        entry->bounds.min_x = header->bounds[0];
+        entry->bounds.max_x = header->bounds[1];
+        entry->bounds.min_y = header->bounds[2];
+        entry->bounds.max_y = header->bounds[3];
+        entry->draw_count = header->draw_count;
+        entry->move_count = header->move_count;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Orders cache files from least to most recently used.
+ */
+static int compare_use(const void* a, const void* b) { // qsort comparator
+    double x = ((const CacheFile*)a)->used, y = ((const CacheFile*)b)->used;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Removes the least recently used cache files until the directory is within its limit.
+ */
+static void evict() { // enforce the size bound
+    DIR* dir = opendir(cache_dir);
+    if (!dir) {
+        return;
+    }
+
+    CacheFile* files = NULL;
+    size_t count = 0, capacity = 0;
+    unsigned long long total = 0;
+    struct dirent* item;
+
+    while ((item = readdir(dir))) {
+        size_t name_length = strlen(item->d_name);
+        char path[CACHE_PATH_SIZE];
+        struct stat info;
+
+        if (name_length != 20 || (strcmp(item->d_name + 16, ".str") != 0 && strcmp(item->d_name + 16, ".geo") != 0)) {
+            continue; // not a cache file
+        }
+
+        snprintf(path, sizeof(path), "%s/%.20s", cache_dir, item->d_name);
+        if (stat(path, &info) != 0) {
+            continue;
+        }
+
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            CacheFile* grown = realloc(files, capacity * sizeof(CacheFile));
+            if (!grown) {
+                break;
+            }
+            files = grown;
+        }
+
+        strcpy(files[count].name, item->d_name);
+        files[count].size = info.st_size;
+        files[count].used = (double)info.st_mtim.tv_sec + info.st_mtim.tv_nsec * 1e-9;
+        total += (unsigned long long)info.st_size;
+        count++;
+    }
+    closedir(dir);
+
+    if (total > cache_limit) {
+        qsort(files, count, sizeof(CacheFile), compare_use);
+
+        for (size_t i = 0; i < count && total > cache_limit; i++) {
+            char path[CACHE_PATH_SIZE];
+            snprintf(path, sizeof(path), "%s/%s", cache_dir, files[i].name);
+
+            if (unlink(path) == 0) {
+                total -= (unsigned long long)files[i].size;
+            }
+        }
+    }
+
+    free(files);
+}
+
+/**
+ * @brief Writes a cache file atomically, then enforces the size limit.
+ *
+ * The file is written under a unique temporary name from mkstemp() and renamed into
+ * place, so a reader never maps a partial entry, and batch jobs storing the same
+ * system at once, which share a pid, each write their own file; the last rename wins.
+ * Entries larger than the limit divided by `CACHE_ENTRY_FRACTION` are not stored, so
+ * one huge system cannot flush the rest of the cache.
+ *
+ * @return 1 if the entry was stored, 0 otherwise.
+ */
+static int store_entry(const L_System* sys, int kind, CacheHeader* header, const void* data, size_t data_size) { // write one file
+    char path[CACHE_PATH_SIZE], temporary[CACHE_PATH_SIZE + 32];
+    static const char zeros[64] = {0};
+
+    if (!cache_enabled || CACHE_DATA_OFFSET + data_size > cache_limit / CACHE_ENTRY_FRACTION || !make_key(sys, kind, header->key)) {
+        return 0;
+    }
+
+    memcpy(header->magic, CACHE_MAGIC, 8);
+    header->version = CACHE_VERSION;
+    header->kind = (uint32_t)kind;
+    header->hash = hash_key(header->key);
+
+    entry_path(header->hash, kind, path);
+    snprintf(temporary, sizeof(temporary), "%s.XXXXXX", path);
+
+    int fd = mkstemp(temporary);
+    if (fd < 0) {
+        return 0;
+    }
+    fchmod(fd, 0644); // mkstemp() creates the file private to its owner
+
+    FILE* file = fdopen(fd, "wb");
+    if (!file) {
+        close(fd);
+        unlink(temporary);
+        return 0;
+    }
+
+    int ok = fwrite(header, sizeof(CacheHeader), 1, file) == 1
+        && fwrite(zeros, 1, CACHE_DATA_OFFSET - sizeof(CacheHeader), file) == CACHE_DATA_OFFSET - sizeof(CacheHeader)
+        && fwrite(data, 1, data_size, file) == data_size;
+    ok = fclose(file) == 0 && ok;
+
+    if (!ok || rename(temporary, path) != 0) {
+        unlink(temporary);
+        return 0;
+    }
+
+    evict();
+    return 1;
+}
+
+/**
+ * @brief Looks up the parsed string of a system.
+ *
+ * @param sys The L-System.
+ * @param entry Filled with the mapped string on a hit. Release it with `cache_entry_free()`.
+ *
+ * @return 1 on a hit, 0 on a miss.
+ */
+int cache_load_string(const L_System* sys, CacheEntry* entry) { // mapped string
+    double span = trace_begin();
+    if (!load_entry(sys, CACHE_STRING, entry)) {
+        return 0;
+    }
+
+    trace_end("cache_hit", span, "bytes", (double)entry->length);
+    return 1;
+}
+
+/**
+ * @brief Stores the parsed string of a system.
+ *
+ * @param sys The L-System.
+ * @param string Its parsed string.
+ * @param length The length of the string, not counting the null terminator.
+ *
+ * @return 1 if the string was stored, 0 otherwise.
+ */
+int cache_store_string(const L_System* sys, const char* string, size_t length) { // save a string for the next run
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.count = length;
+
+    double span = trace_begin();
+    if (!store_entry(sys, CACHE_STRING, &header, string, length + 1)) {
+        return 0;
+    }
+
+    trace_end("cache_store", span, "bytes", (double)length);
+    return 1;
+}
+
+/**
+ * @brief Returns the parsed string of a system, from the cache when possible.
+ *
+ * On a hit the string is mapped read-only from its cache file, so a system parsed by
+ * an earlier run is ready without any expansion. On a miss it is parsed with `parser()`
+ * and stored for next time. Either way, release it with `cache_entry_free()`.
+ *
+ * @param sys The L-System to parse.
+ * @param entry Filled with the string and its length.
+ *
+ * @return 1 on success, 0 if the string is not cached and cannot be parsed.
+ */
+int cache_parse(const L_System* sys, CacheEntry* entry) { // parser() behind the cache
+    if (cache_load_string(sys, entry)) {
+        return 1;
+    }
+
+    L_System copy = *sys; // parser() takes a mutable rule array
+    entry->owned = parser(copy.axiom, copy.rules, copy.iterations);
+    if (!entry->owned) {
+        return 0;
+    }
+    entry->string = entry->owned;
+    entry->length = strlen(entry->owned);
+
+    cache_store_string(sys, entry->string, entry->length);
+    return 1;
+}
+
+/**
+ * @brief Looks up the turtle geometry of a system: its segments, bounds and step counts.
+ *
+ * @param sys The L-System, including its turn angle and start direction.
+ * @param entry Filled with the mapped geometry on a hit. Release it with `cache_entry_free()`.
+ *
+ * @return 1 on a hit, 0 on a miss.
+ */
+int cache_load_geometry(const L_System* sys, CacheEntry* entry) { // mapped segments
+    return load_entry(sys, CACHE_GEOMETRY, entry);
+}
+
+/**
+ * @brief Stores the turtle geometry of a system, after its turtle has been finished.
+ *
+ * @param sys The L-System, including its turn angle and start direction.
+ * @param turtle The turtle that interpreted it, with its segment array.
+ *
+ * @return 1 if the geometry was stored, 0 otherwise.
+ */
+int cache_store_geometry(const L_System* sys, const Turtle* turtle) { // save segments for the next run
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+
+    header.count = turtle->segment_count;
+    header.bounds[0] = turtle->min_x;
+    header.bounds[1] = turtle->max_x;
+    header.bounds[2] = turtle->min_y;
+    header.bounds[3] = turtle->max_y;
+    header.draw_count = turtle->draw_count;
+    header.move_count = turtle->move_count;
+
+    return store_entry(sys, CACHE_GEOMETRY, &header, turtle->segments, turtle->segment_count * 4 * sizeof(float));
+}
+
+/**
+ * @brief Releases a cache entry: unmaps its file or frees the string it computed.
+ *
+ * @param entry The entry to release.
+ */
+void cache_entry_free(CacheEntry* entry) { // unmap or free
+    if (entry->map) {
+        munmap(entry->map, entry->map_size);
+    }
+    free(entry->owned);
+    memset(entry, 0, sizeof(CacheEntry));
+}
@@ -0,0 +1,279 @@
+#include "dedup.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#define SEGMENT_SET_MIN_CAPACITY 1024 // starting number of slots, always a power of two
+
+/**
+ * @brief Orders quantized endpoints into a hash set key.
+ *
+ * The endpoints are ordered so that a segment and its reverse get the same key.
+ *
+ * @param q The quantized x0, y0, x1, y1.
+ * @param key The key to fill.
+ */
+static void make_key(const long long* q, SegmentKey* key) { // order the endpoints
+    int reverse = q[2] < q[0] || (q[2] == q[0] && q[3] < q[1]);
+
+    key->endpoints[0] = reverse ? q[2] : q[0];
+    key->endpoints[1] = reverse ? q[3] : q[1];
+    key->endpoints[2] = reverse ? q[0] : q[2];
+    key->endpoints[3] = reverse ? q[1] : q[3];
+}
+
+/**
+ * @brief Hashes a segment key.
+ *
+ * @param key The key to hash.
+ *
+ * @return A 64-bit hash with well mixed low bits, used to pick the home slot.
+ */
+static uint64_t hash_key(const SegmentKey* key) { // mix the four coordinates
+    uint64_t hash = 0x9E3779B97F4A7C15ULL;
+
+    for (int i = 0; i < 4; i++) {
+        hash ^= (uint64_t)key->endpoints[i];
+        hash *= 0xBF58476D1CE4E5B9ULL;
+        hash ^= hash >> 31;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Finds the slot that holds a key, or the empty slot where it belongs.
+ *
+ * @param keys The slots.
+ * @param used Which slots hold a key.
+ * @param capacity The number of slots, a power of two.
+ * @param key The key to look for.
+ *
+ * @return The index of the slot.
+ */
+static size_t find_slot(const SegmentKey* keys, const unsigned char* used, size_t capacity, const SegmentKey* key) { // linear probe
+    size_t slot = (size_t)hash_key(key) & (capacity - 1);
+
+    while (used[slot] && memcmp(&keys[slot], key, sizeof(SegmentKey)) != 0) {
+        slot = (slot + 1) & (capacity - 1);
+    }
+
+    return slot;
+}
+
+/**
+ * @brief Doubles the number of slots and reinserts every key.
+ *
+ * @param set The set to grow.
+ *
+ * @return 1 on success, 0 if allocation fails, in which case the set is unchanged.
+ */
+static int grow_set(SegmentSet* set) { // rehash into twice the slots
+    size_t capacity = set->capacity * 2;
+    SegmentKey* keys = malloc(capacity * sizeof(SegmentKey));
+    unsigned char* used = calloc(capacity, 1);
+
+    if (!keys || !used) {
+        free(keys);
+        free(used);
+        return 0;
+    }
+
+    for (size_t i = 0; i < set->capacity; i++) {
+        if (set->used[i]) {
+            size_t slot = find_slot(keys, used, capacity, &set->keys[i]);
+            keys[slot] = set->keys[i];
+            used[slot] = 1;
+        }
+    }
+
+    free(set->keys);
+    free(set->used);
+    set->keys = keys;
+    set->used = used;
+    set->capacity = capacity;
+
+    return 1;
+}
+
+/**
+ * @brief Prepares an empty segment set.
+ *
+ * @param set The set to initialize.
+ * @param quantum The grid spacing endpoints are snapped to. Must be positive.
+ *
+ * @return 1 on success, 0 if the quantum is invalid or allocation fails.
+ */
+int segment_set_init(SegmentSet* set, double quantum) { // allocate the starting slots
+    if (!(quantum > 0)) {
+        return 0;
+    }
+
+    set->keys = malloc(SEGMENT_SET_MIN_CAPACITY * sizeof(SegmentKey));
+    set->used = calloc(SEGMENT_SET_MIN_CAPACITY, 1);
+    if (!set->keys || !set->used) {
+        free(set->keys);
+        free(set->used);
+        return 0;
+    }
+
+    set->capacity = SEGMENT_SET_MIN_CAPACITY;
+    set->size = 0;
+    set->quantum = quantum;
+
+    return 1;
+}
+
+/**
+ * @brief Adds a segment to the set unless an equal one is already there.
+ *
+ * Each coordinate is snapped to the nearest multiple of the quantum, which absorbs the
+ * rounding drift a turtle accumulates when it returns to a point along a different path.
+ * Two equal points can still fall on either side of a rounding boundary, so a coordinate
+ * within `DEDUP_NEIGHBOUR` of a boundary also looks in the cell across it, and endpoints
+ * closer than that always match. Segments are compared whole, in either direction.
+ * The set doubles whenever it would become more than half full, which keeps probe
+ * sequences short.
+ *
+ * @param set The set to add to.
+ * @param segment The segment, as x0, y0, x1, y1.
+ * @param inserted Set to 1 if the segment was new, 0 if it is a duplicate.
+ *
+ * @return 1 on success, 0 if allocation fails.
+ */
+int segment_set_insert(SegmentSet* set, const float* segment, int* inserted) { // insert if absent
+    if ((set->size + 1) * 2 > set->capacity && !grow_set(set)) {
+        return 0;
+    }
+
+    long long q[4], across[4];
+    int near = 0; // bit i is set when coordinate i is near a rounding boundary
+    for (int i = 0; i < 4; i++) {
+        double scaled = segment[i] / set->quantum;
+        q[i] = llround(scaled);
+        across[i] = scaled > q[i] ? q[i] + 1 : q[i] - 1;
+        if (fabs(scaled - q[i]) > 0.5 - DEDUP_NEIGHBOUR) {
+            near |= 1 << i;
+        }
+    }
+
+    SegmentKey key;
+    for (int mask = near; ; mask = (mask - 1) & near) { // every mix of nearest and neighbouring cells, the nearest last
+        long long cell[4];
+        for (int i = 0; i < 4; i++) {
+            cell[i] = mask & (1 << i) ? across[i] : q[i];
+        }
+        make_key(cell, &key);
+
+        if (mask != 0 && set->used[find_slot(set->keys, set->used, set->capacity, &key)]) {
+            *inserted = 0;
+            return 1;
+        }
+        if (mask == 0) {
+            break;
+        }
+    }
+
+    size_t slot = find_slot(set->keys, set->used, set->capacity, &key);
+    *inserted = !set->used[slot];
+
+    if (*inserted) {
+        set->keys[slot] = key;
+        set->used[slot] = 1;
+        set->size++;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Widens a dedup quantum so it is never finer than float32 spacing within some bounds.
+ *
+ * Segments are stored as float32, whose spacing grows with the coordinates, so far from
+ * the origin two copies of a point can differ by more than the quantum. The result
+ * covers `DEDUP_ULPS` float32 steps at the coordinate farthest from the origin, but never
+ * exceeds `DEDUP_MAX_QUANTUM`, so distinct turtle steps are never merged.
+ *
+ * @param quantum The requested grid spacing.
+ * @param bounds The bounds of every segment that will be compared.
+ *
+ * @return The grid spacing to use.
+ */
+double dedup_quantum(double quantum, const Bounds* bounds) { // scale with float32 precision
+    double extent = fmax(fmax(fabs(bounds->min_x), fabs(bounds->max_x)), fmax(fabs(bounds->min_y), fabs(bounds->max_y)));
+    double spacing = DEDUP_ULPS * FLT_EPSILON * extent;
+
+    if (spacing > quantum) {
+        quantum = spacing;
+    }
+    return quantum < DEDUP_MAX_QUANTUM ? quantum : DEDUP_MAX_QUANTUM;
+}
+
+/**
+ * @brief Releases the memory held by a segment set.
+ *
+ * @param set The set to free.
+ */
+void segment_set_free(SegmentSet* set) { // free the slots
+    free(set->keys);
+    free(set->used);
+    set->keys = NULL;
+    set->used = NULL;
+    set->capacity = 0;
+    set->size = 0;
+}
+
+/**
+ * @brief Removes duplicate segments from an array, keeping the first of each.
+ *
+ * Bracketed grammars often return to an earlier position with ']' and draw over
+ * segments that are already there. This compacts the array in place so only one copy
+ * of each segment remains, in the original order, leaving the rendered geometry the same.
+ * Matching is approximate: see `segment_set_insert()`. The turtle has already merged
+ * collinear steps, so overlapping runs of different lengths are not duplicates here.
+ *
+ * @param segments The segments, 4 floats each, as written by the turtle.
+ * @param segment_count The number of segments, updated to the number kept.
+ * @param quantum The grid spacing endpoints are snapped to before comparing.
+ * @param removed Receives the number of segments removed. May be NULL.
+ *
+ * @return 1 on success, 0 on failure, in which case the array is unchanged.
+ */
+int dedup_segments(float* segments, size_t* segment_count, double quantum, size_t* removed) { // drop repeated segments
+    SegmentSet set;
+    if (!segment_set_init(&set, quantum)) {
+        return 0;
+    }
+
+    while (set.capacity / 2 < *segment_count) { // size the set up front so no insert can fail halfway
+        if (!grow_set(&set)) {
+            segment_set_free(&set);
+            return 0;
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < *segment_count; i++) {
+        int inserted;
+
+        segment_set_insert(&set, segments + i * 4, &inserted);
+
+        if (inserted) {
+            memmove(segments + kept * 4, segments + i * 4, 4 * sizeof(float));
+            kept++;
+        }
+    }
+
+    segment_set_free(&set);
+
+    if (removed) {
+        *removed = *segment_count - kept;
+    }
+    *segment_count = kept;
+
+    return 1;
+}
@@ -0,0 +1,230 @@
+#include "expansion.h"
+#include "length.h"
+#include "parser.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Initializes an empty handle, which matches no grammar.
+ *
+ * @param handle The handle to initialize.
+ */
+void expansion_init(ExpansionHandle* handle) { // no grammar yet
+    memset(handle, 0, sizeof(ExpansionHandle));
+}
+
+/**
+ * @brief Checks whether a handle holds the generations of a grammar.
+ *
+ * Rules are compared in order up to the terminating rule with a '\0' character, so
+ * anything left after it in the array does not matter.
+ *
+ * @param handle The handle.
+ * @param axiom The axiom string.
+ * @param rules The set of rules.
+ *
+ * @return 1 if the handle was built from the same axiom and rules, 0 otherwise.
+ */
+int expansion_matches(const ExpansionHandle* handle, const char* axiom, Rule rules[]) { // same grammar?
+    if (!handle->valid || strcmp(handle->axiom, axiom) != 0) {
+        return 0;
+    }
+
+    for (int i = 0; i < SIZE; i++) {
+        if (handle->rules[i].character != rules[i].character) {
+            return 0;
+        }
+        if (rules[i].character == '\0') {
+            return 1;
+        }
+        if (strcmp(handle->rules[i].rule, rules[i].rule) != 0) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Starts a handle over for a new grammar: copies it, compiles its rules and keeps its axiom as generation 0.
+ *
+ * @return 1 on success, 0 if allocation fails.
+ */
+static int expansion_reset(ExpansionHandle* handle, const char* axiom, Rule rules[]) { // adopt a grammar
+    expansion_free(handle);
+
+    snprintf(handle->axiom, SIZE, "%s", axiom);
+    for (int i = 0; i < SIZE; i++) {
+        handle->rules[i] = rules[i];
+        if (rules[i].character == '\0') {
+            break;
+        }
+    }
+
+    handle->generations = calloc(1, sizeof(char*));
+    handle->lengths = calloc(1, sizeof(size_t));
+    if (!handle->generations || !handle->lengths || !compile_rules(&handle->table, handle->rules)) {
+        expansion_free(handle);
+        return 0;
+    }
+
+    handle->lengths[0] = strlen(handle->axiom);
+    handle->generations[0] = malloc(handle->lengths[0] + 1);
+    if (!handle->generations[0]) {
+        free_rule_table(&handle->table);
+        expansion_free(handle);
+        return 0;
+    }
+
+    strcpy(handle->generations[0], handle->axiom);
+    handle->capacity = 1;
+    handle->count = 1;
+    handle->valid = 1;
+
+    return 1;
+}
+
+/**
+ * @brief Makes room for generations up to `iterations` and fills in their exact lengths.
+ *
+ * @return 1 on success, 0 if a length overflows size_t or allocation fails.
+ */
+static int expansion_reserve(ExpansionHandle* handle, int iterations) { // grow the generation arrays
+    if (iterations < handle->capacity) {
+        return 1;
+    }
+
+    char** generations = realloc(handle->generations, (size_t)(iterations + 1) * sizeof(char*));
+    if (!generations) {
+        return 0;
+    }
+    handle->generations = generations;
+
+    size_t* lengths = realloc(handle->lengths, (size_t)(iterations + 1) * sizeof(size_t));
+    if (!lengths) {
+        return 0;
+    }
+    handle->lengths = lengths;
+
+    if (!calculate_generation_lengths(handle->axiom, handle->rules, iterations, handle->lengths)) {
+        return 0; // the capacity is left alone, so the lengths past it are never trusted
+    }
+
+    for (int i = handle->capacity; i <= iterations; i++) {
+        handle->generations[i] = NULL;
+    }
+    handle->capacity = iterations + 1;
+
+    return 1;
+}
+
+/**
+ * @brief Drops earlier generations until the ones kept fit in `EXPANSION_KEEP_LIMIT`.
+ *
+ * The largest are dropped first, since each frees the most memory and is rebuilt from
+ * the next kept generation below it. The axiom, the newest generation, which later
+ * calls resume from, and the generation just built, which the next step expands, are
+ * never dropped.
+ */
+static void expansion_trim(ExpansionHandle* handle, int built) { // bound the memory of earlier generations
+    for (int i = handle->count - 2; i > 0 && handle->kept > EXPANSION_KEEP_LIMIT; i--) {
+        if (i == built || !handle->generations[i]) {
+            continue;
+        }
+
+        free(handle->generations[i]);
+        handle->generations[i] = NULL;
+        handle->kept -= handle->lengths[i] + 1;
+    }
+}
+
+/**
+ * @brief Returns a generation of a grammar, resuming from the generations a handle already holds.
+ *
+ * The first call for a grammar compiles its rules and expands from the axiom, like
+ * `parser_breadth_first()`. Later calls with the same axiom and rules reuse that work:
+ * raising the iteration count resumes from the newest generation held, so trying a
+ * system at 6, then 7, then 8 iterations costs one generation per step, and lowering it
+ * returns a generation kept from before, or rebuilds it from the closest one below it
+ * if it was dropped to stay within `EXPANSION_KEEP_LIMIT`. A different grammar starts
+ * the handle over. Each generation is allocated once at its exact length, from
+ * `calculate_generation_lengths()`, so `iterate()` never resizes it.
+ *
+ * @param handle The handle, from `expansion_init()`.
+ * @param axiom The axiom string.
+ * @param rules The set of rules to apply.
+ * @param iterations The number of iterations to apply the rules.
+ * @param length Receives the length of the result, not counting the null terminator. May be NULL.
+ *
+ * @return The generation, owned by the handle and valid until its next call, or NULL if a length overflows size_t or allocation fails.
+ */
+const char* expansion_get(ExpansionHandle* handle, const char* axiom, Rule rules[], int iterations, size_t* length) { // incremental parser function
+    if (iterations < 0) {
+        return NULL;
+    }
+    if (!expansion_matches(handle, axiom, rules) && !expansion_reset(handle, axiom, rules)) {
+        return NULL;
+    }
+    if (!expansion_reserve(handle, iterations)) {
+        return NULL;
+    }
+
+    int start = iterations < handle->count ? iterations : handle->count - 1;
+    while (!handle->generations[start]) { // the closest generation held at or below the target
+        start--;
+    }
+
+    for (int i = start; i < iterations; i++) {
+        size_t buffer_size = handle->lengths[i + 1] + 1;
+        char* next = malloc(buffer_size);
+        if (!next) {
+            return NULL;
+        }
+
+        double span = trace_begin();
+        if (!iterate(handle->generations[i], &next, &buffer_size, &handle->table)) {
+            trace_end("iterate", span, NULL, 0);
+            free(next);
+            return NULL;
+        }
+        trace_end("iterate", span, "bytes", (double)handle->lengths[i + 1]);
+        trace_counter("generation_bytes", (double)handle->lengths[i + 1]);
+
+        handle->generations[i + 1] = next;
+        if (i + 1 < handle->count) { // rebuilding a dropped generation below the newest
+            handle->kept += handle->lengths[i + 1] + 1;
+        } else { // a new newest generation, and the previous newest becomes an earlier one
+            handle->kept += handle->lengths[handle->count - 1] + 1;
+            handle->count = i + 2;
+        }
+        expansion_trim(handle, i + 1);
+    }
+
+    if (length) {
+        *length = handle->lengths[iterations];
+    }
+    return handle->generations[iterations];
+}
+
+/**
+ * @brief Frees every generation a handle holds, along with its compiled rules.
+ *
+ * @param handle The handle, left empty, as from `expansion_init()`.
+ */
+void expansion_free(ExpansionHandle* handle) { // release the generations
+    if (handle->generations) {
+        for (int i = 0; i < handle->capacity; i++) {
+            free(handle->generations[i]);
+        }
+    }
+    if (handle->valid) {
+        free_rule_table(&handle->table);
+    }
+
+    free(handle->generations);
+    free(handle->lengths);
+    expansion_init(handle);
+}
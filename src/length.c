@@ -0,0 +1,243 @@
+#include "length.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief Adds a symbol to the alphabet of a transition matrix if it is not already there.
+ *
+ * @param matrix The matrix whose alphabet is being built.
+ * @param c The symbol to add.
+ */
+static void add_symbol(TransitionMatrix* matrix, unsigned char c) { // register a symbol once
+    if (matrix->index_of[c] == -1) {
+        matrix->index_of[c] = matrix->size;
+        matrix->symbols[matrix->size] = c;
+        matrix->size++;
+    }
+}
+
+/**
+ * @brief Builds the symbol-count transition matrix of an L-System.
+ *
+ * The alphabet is every symbol that appears in the axiom, as a rule character, or
+ * in a rule body. Row `from` of the matrix counts the symbols that one `from`
+ * becomes after a single iteration: its rule body if it has a rule, or itself if it
+ * does not. If a character has more than one rule, the first one wins, matching `iterate()`.
+ *
+ * @param matrix The matrix to build.
+ * @param axiom The axiom string.
+ * @param rules The set of rules, terminated by a rule with a '\0' character.
+ *
+ * @return 1 on success, 0 if allocation fails.
+ */
+int build_transition_matrix(TransitionMatrix* matrix, const char* axiom, Rule rules[]) { // count what each symbol turns into
+    const char* rule_for[256] = {0};
+
+    matrix->size = 0;
+    matrix->produces = NULL;
+    for (int c = 0; c < 256; c++) {
+        matrix->index_of[c] = -1;
+    }
+
+    for (size_t i = 0; axiom[i] != '\0'; i++) {
+        add_symbol(matrix, (unsigned char)axiom[i]);
+    }
+
+    for (int i = 0; rules[i].character != '\0'; i++) { // collect the alphabet and the first rule of each character
+        unsigned char c = (unsigned char)rules[i].character;
+        add_symbol(matrix, c);
+
+        if (!rule_for[c]) {
+            rule_for[c] = rules[i].rule;
+        }
+
+        for (size_t j = 0; rules[i].rule[j] != '\0'; j++) {
+            add_symbol(matrix, (unsigned char)rules[i].rule[j]);
+        }
+    }
+
+    matrix->produces = calloc((size_t)matrix->size * matrix->size, sizeof(size_t));
+    if (!matrix->produces && matrix->size > 0) {
+        return 0;
+    }
+
+    for (int from = 0; from < matrix->size; from++) { // fill each row with the symbol counts of one iteration
+        const char* body = rule_for[matrix->symbols[from]];
+        size_t* row = matrix->produces + (size_t)from * matrix->size;
+
+        if (!body) {
+            row[from] = 1; // no rule, the symbol is copied through
+            continue;
+        }
+
+        for (size_t j = 0; body[j] != '\0'; j++) {
+            row[matrix->index_of[(unsigned char)body[j]]]++;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Releases the memory held by a transition matrix.
+ *
+ * @param matrix The matrix to free.
+ */
+void free_transition_matrix(TransitionMatrix* matrix) { // free the matrix cells
+    free(matrix->produces);
+    matrix->produces = NULL;
+    matrix->size = 0;
+}
+
+/**
+ * @brief Calculates the exact length of every generation of an L-System.
+ *
+ * This function starts from the symbol counts of the axiom and multiplies them by the
+ * transition matrix once per iteration, so the cost depends on the alphabet size and
+ * the number of iterations only, never on the length of the strings. Every addition
+ * and multiplication is checked, so a length that does not fit in a size_t is reported
+ * before any buffer is allocated.
+ *
+ * @param axiom The axiom string.
+ * @param rules The set of rules to apply.
+ * @param iterations The number of iterations to apply the rules.
+ * @param lengths An array of `iterations + 1` entries that receives the length of each generation,
+ * not counting the null terminator. Entry 0 is the length of the axiom.
+ *
+ * @return 1 on success, 0 if a length overflows size_t or allocation fails.
+ */
+int calculate_generation_lengths(const char* axiom, Rule rules[], int iterations, size_t lengths[]) { // exact length of each generation
+    TransitionMatrix matrix;
+    if (iterations < 0 || !build_transition_matrix(&matrix, axiom, rules)) {
+        return 0;
+    }
+
+    size_t* vectors = calloc((size_t)matrix.size * 2 + 1, sizeof(size_t));
+    if (!vectors) {
+        free_transition_matrix(&matrix);
+        return 0;
+    }
+
+    size_t* counts = vectors;
+    size_t* next_counts = vectors + matrix.size; // "ping pong" count vectors
+
+    for (size_t i = 0; axiom[i] != '\0'; i++) {
+        counts[matrix.index_of[(unsigned char)axiom[i]]]++;
+    }
+    lengths[0] = strlen(axiom);
+
+    int ok = 1;
+    for (int iteration = 1; iteration <= iterations && ok; iteration++) { // next_counts = counts * matrix
+        memset(next_counts, 0, (size_t)matrix.size * sizeof(size_t));
+        size_t total = 0;
+
+        for (int from = 0; from < matrix.size && ok; from++) {
+            const size_t* row = matrix.produces + (size_t)from * matrix.size;
+
+            for (int to = 0; to < matrix.size; to++) {
+                if (row[to] == 0 || counts[from] == 0) {
+                    continue;
+                }
+
+                if (counts[from] > SIZE_MAX / row[to]) { // multiplication overflow
+                    ok = 0;
+                    break;
+                }
+
+                size_t produced = counts[from] * row[to];
+                if (total > SIZE_MAX - produced) { // addition overflow, the total bounds every single count
+                    ok = 0;
+                    break;
+                }
+
+                next_counts[to] += produced;
+                total += produced;
+            }
+        }
+
+        if (ok && total == SIZE_MAX) { // leave room for the null terminator
+            ok = 0;
+        }
+
+        lengths[iteration] = total;
+
+        size_t* temp = counts;
+        counts = next_counts;
+        next_counts = temp; // swap count vectors
+    }
+
+    free(vectors);
+    free_transition_matrix(&matrix);
+
+    return ok;
+}
+
+/**
+ * @brief Calculates the exact length of the final generation of an L-System.
+ *
+ * @param axiom The axiom string.
+ * @param rules The set of rules to apply.
+ * @param iterations The number of iterations to apply the rules.
+ * @param length A pointer that receives the length of the parsed string, not counting the null terminator.
+ *
+ * @return 1 on success, 0 if the length overflows size_t or allocation fails.
+ */
+int calculate_parsed_length(const char* axiom, Rule rules[], int iterations, size_t* length) { // exact length of the parsed string
+    if (iterations < 0) {
+        return 0;
+    }
+
+    size_t* lengths = malloc((size_t)(iterations + 1) * sizeof(size_t));
+    if (!lengths) {
+        return 0;
+    }
+
+    int ok = calculate_generation_lengths(axiom, rules, iterations, lengths);
+    if (ok) {
+        *length = lengths[iterations];
+    }
+
+    free(lengths);
+    return ok;
+}
+
+/**
+ * @brief Calculates the buffer size needed to hold every generation of an L-System.
+ *
+ * This is the length of the longest generation plus one for the null terminator, which
+ * lets "ping pong" buffers be allocated once and never resized.
+ *
+ * @param axiom The axiom string.
+ * @param rules The set of rules to apply.
+ * @param iterations The number of iterations to apply the rules.
+ * @param buffer_size A pointer that receives the buffer size, in bytes.
+ *
+ * @return 1 on success, 0 if a length overflows size_t or allocation fails.
+ */
+int calculate_buffer_size(const char* axiom, Rule rules[], int iterations, size_t* buffer_size) { // size of the longest generation
+    if (iterations < 0) {
+        return 0;
+    }
+
+    size_t* lengths = malloc((size_t)(iterations + 1) * sizeof(size_t));
+    if (!lengths) {
+        return 0;
+    }
+
+    int ok = calculate_generation_lengths(axiom, rules, iterations, lengths);
+    if (ok) {
+        *buffer_size = 0;
+
+        for (int iteration = 0; iteration <= iterations; iteration++) {
+            if (lengths[iteration] + 1 > *buffer_size) {
+                *buffer_size = lengths[iteration] + 1;
+            }
+        }
+    }
+
+    free(lengths);
+    return ok;
+}
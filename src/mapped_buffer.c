@@ -0,0 +1,237 @@
+#include "mapped_buffer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+static MappedBuffer mapped_buffers[MAPPED_BUFFER_MAX]; // every live mapping, so a pointer alone identifies its range
+static pthread_mutex_t mapped_buffers_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Rounds a size up to a whole number of commit steps.
+ */
+static size_t round_to_step(size_t size) { // whole huge pages
+    return (size + MAPPED_BUFFER_STEP - 1) / MAPPED_BUFFER_STEP * MAPPED_BUFFER_STEP;
+}
+
+/**
+ * @brief Reads how many bytes of 2 MiB hugetlb pages are free, from /proc/meminfo.
+ *
+ * @return The free bytes, or 0 if there are none, the huge page size differs or the file is unreadable.
+ */
+static size_t free_huge_bytes() { // explicit huge pages reserved by the administrator
+    FILE* file = fopen("/proc/meminfo", "r");
+    char line[128];
+    size_t free_pages = 0, page_kb = 0;
+
+    while (file && fgets(line, sizeof(line), file)) {
+        sscanf(line, "HugePages_Free: %zu", &free_pages);
+        sscanf(line, "Hugepagesize: %zu kB", &page_kb);
+    }
+    if (file) {
+        fclose(file);
+    }
+
+    return page_kb * 1024 == MAPPED_BUFFER_STEP ? free_pages * MAPPED_BUFFER_STEP : 0;
+}
+
+/**
+ * @brief Finds the registry entry of a buffer. Call with the lock held.
+ *
+ * @return The entry, or NULL if the buffer was not created by `mapped_buffer_create()`.
+ */
+static MappedBuffer* find_buffer(const char* buffer) { // registry lookup
+    for (int i = 0; buffer && i < MAPPED_BUFFER_MAX; i++) {
+        if (mapped_buffers[i].base == buffer) {
+            return &mapped_buffers[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Reserves an address range with nothing committed, aligned to the huge page size.
+ *
+ * When enough hugetlb pages are free to hold the first commit, the range is mapped with
+ * MAP_HUGETLB at exactly that size. It is mapped without MAP_NORESERVE, so the kernel
+ * takes its pages out of the pool when the range is mapped, or refuses the mapping, and
+ * a later page fault can never find the pool empty. A hugetlb buffer therefore cannot
+ * grow; `buffer_resize()` moves it to the heap when it runs out. Otherwise the range is a
+ * large normal anonymous reservation marked with MADV_HUGEPAGE, so transparent huge
+ * pages back it where the kernel allows them.
+ *
+ * @param commit The bytes the caller will commit first, a whole number of steps.
+ * @param entry The registry entry to fill.
+ *
+ * @return 1 on success, 0 if the range cannot be reserved.
+ */
+static int reserve_range(size_t commit, MappedBuffer* entry) { // address space only, no memory yet
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+#ifdef MAP_HUGETLB
+    if (free_huge_bytes() >= commit) { // the mapping itself can still fail if another process takes the pages first
+        void* base = mmap(NULL, commit, PROT_NONE, flags | MAP_HUGETLB, -1, 0);
+
+        if (base != MAP_FAILED) {
+            entry->base = base;
+            entry->reserved = commit;
+            entry->huge = 1;
+            return 1;
+        }
+    }
+#endif
+
+    flags |= MAP_NORESERVE; // only the committed part of a normal range is ever backed
+    size_t reserved = commit > MAPPED_BUFFER_RESERVE ? commit : MAPPED_BUFFER_RESERVE;
+    char* mapping = mmap(NULL, reserved + MAPPED_BUFFER_STEP, PROT_NONE, flags, -1, 0); // one extra step to align within
+    if (mapping == MAP_FAILED) {
+        return 0;
+    }
+
+    char* base = (char*)round_to_step((uintptr_t)mapping);
+    size_t head = base - mapping;
+    if (head > 0) {
+        munmap(mapping, head); // trim the unaligned edges
+    }
+    munmap(base + reserved, MAPPED_BUFFER_STEP - head);
+
+#ifdef MADV_HUGEPAGE
+    madvise(base, reserved, MADV_HUGEPAGE); // only a hint, THP may be disabled
+#endif
+
+    entry->base = base;
+    entry->reserved = reserved;
+    entry->huge = 0;
+    return 1;
+}
+
+/**
+ * @brief Creates a buffer that can grow in place.
+ *
+ * A large range of address space is reserved up front, and only the first `size`
+ * bytes, rounded up to whole huge pages, are made readable and writable. Growing the
+ * buffer with `mapped_buffer_grow()` commits more of the same range, so its contents
+ * never move and are never copied. A buffer backed by hugetlb pages is mapped at exactly
+ * its first commit instead, and cannot grow. Release the buffer with `mapped_buffer_release()`.
+ *
+ * @param size The bytes to commit at first.
+ *
+ * @return The buffer, or NULL if the range cannot be mapped or too many buffers are alive.
+ */
+char* mapped_buffer_create(size_t size) { // reserve, then commit the first part
+    size_t commit = round_to_step(size > 0 ? size : 1);
+    MappedBuffer* entry = NULL;
+
+    pthread_mutex_lock(&mapped_buffers_lock);
+
+    for (int i = 0; i < MAPPED_BUFFER_MAX; i++) {
+        if (!mapped_buffers[i].base) {
+            entry = &mapped_buffers[i];
+            break;
+        }
+    }
+
+    if (!entry || !reserve_range(commit, entry)) {
+        pthread_mutex_unlock(&mapped_buffers_lock);
+        return NULL;
+    }
+
+    if (mprotect(entry->base, commit, PROT_READ | PROT_WRITE) != 0) {
+        munmap(entry->base, entry->reserved);
+        memset(entry, 0, sizeof(MappedBuffer));
+        pthread_mutex_unlock(&mapped_buffers_lock);
+        return NULL;
+    }
+    entry->committed = commit;
+
+    char* buffer = entry->base;
+    pthread_mutex_unlock(&mapped_buffers_lock);
+
+    return buffer;
+}
+
+/**
+ * @brief Commits more of a buffer's range so it holds at least `size` bytes, without moving it.
+ *
+ * @param buffer A buffer from `mapped_buffer_create()`.
+ * @param size The bytes the buffer must hold.
+ *
+ * @return 1 on success, 0 if the buffer is not mapped, `size` is past its reservation or the commit fails.
+ */
+int mapped_buffer_grow(char* buffer, size_t size) { // commit on demand
+    pthread_mutex_lock(&mapped_buffers_lock);
+
+    MappedBuffer* entry = find_buffer(buffer);
+    int ok = entry && size <= entry->reserved;
+
+    if (ok && size > entry->committed) {
+        size_t commit = round_to_step(size);
+        if (commit > entry->reserved) {
+            commit = entry->reserved;
+        }
+
+        ok = mprotect(entry->base + entry->committed, commit - entry->committed, PROT_READ | PROT_WRITE) == 0;
+        if (ok) {
+            entry->committed = commit;
+        }
+    }
+
+    pthread_mutex_unlock(&mapped_buffers_lock);
+    return ok;
+}
+
+/**
+ * @brief Returns a buffer's pages to the kernel while keeping its range committed.
+ *
+ * The contents are lost: the next write to each page faults in a fresh zeroed page.
+ * Used on the ping-pong buffer that was just swapped out, whose old generation is no
+ * longer needed, so it does not hold memory until it is overwritten. Buffers with less
+ * than `MAPPED_BUFFER_DISCARD_MIN` committed are left alone.
+ *
+ * @param buffer A buffer from `mapped_buffer_create()`.
+ *
+ * @return 1 if the pages were released or the buffer is too small to bother, 0 if the buffer is not mapped.
+ */
+int mapped_buffer_discard(char* buffer) { // MADV_DONTNEED the committed pages
+    pthread_mutex_lock(&mapped_buffers_lock);
+
+    MappedBuffer* entry = find_buffer(buffer);
+    int ok = entry && (entry->committed < MAPPED_BUFFER_DISCARD_MIN || madvise(entry->base, entry->committed, MADV_DONTNEED) == 0);
+
+    pthread_mutex_unlock(&mapped_buffers_lock);
+    return ok;
+}
+
+/**
+ * @brief Unmaps a buffer's whole range.
+ *
+ * @param buffer A buffer from `mapped_buffer_create()`.
+ *
+ * @return 1 if the buffer was unmapped, 0 if it was not created by `mapped_buffer_create()`.
+ */
+int mapped_buffer_release(char* buffer) { // give back the reservation
+    pthread_mutex_lock(&mapped_buffers_lock);
+
+    MappedBuffer* entry = find_buffer(buffer);
+    if (entry) {
+        munmap(entry->base, entry->reserved);
+        memset(entry, 0, sizeof(MappedBuffer));
+    }
+
+    pthread_mutex_unlock(&mapped_buffers_lock);
+    return entry != NULL;
+}
+
+/**
+ * @brief Reports whether a pointer is the start of a buffer from `mapped_buffer_create()`.
+ */
+int mapped_buffer_owns(const char* buffer) { // registry membership
+    pthread_mutex_lock(&mapped_buffers_lock);
+    int owned = find_buffer(buffer) != NULL;
+    pthread_mutex_unlock(&mapped_buffers_lock);
+
+    return owned;
+}
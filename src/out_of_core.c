@@ -0,0 +1,139 @@
+#include "out_of_core.h"
+#include "length.h"
+#include "stream.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/**
+ * @brief Streams the expansion into the file through one writable window at a time.
+ *
+ * Each window's blocks are allocated with posix_fallocate() just before it is mapped,
+ * so a full disk is reported as an error rather than a SIGBUS on write, and the part of
+ * the file not yet reached stays sparse. Each window is unmapped once written, leaving
+ * its pages to the page cache to write back and evict, so memory use stays at about one
+ * window however long the string is.
+ *
+ * @return 1 on success, 0 if a window cannot be allocated or mapped.
+ */
+static int write_windows(int fd, LStream* stream, size_t length) { // sequential writes through mmap
+    for (size_t offset = 0; offset < length; offset += OUT_OF_CORE_WINDOW) {
+        size_t window = length - offset < OUT_OF_CORE_WINDOW ? length - offset : OUT_OF_CORE_WINDOW;
+
+        if (posix_fallocate(fd, (off_t)offset, (off_t)window) != 0) {
+            return 0;
+        }
+
+        char* map = mmap(NULL, window, PROT_READ | PROT_WRITE, MAP_SHARED, fd, (off_t)offset);
+        if (map == MAP_FAILED) {
+            return 0;
+        }
+
+        madvise(map, window, MADV_SEQUENTIAL);
+        stream_read(stream, map, window);
+        munmap(map, window);
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Maps a written file read-only, with a zero page after it as the null terminator.
+ *
+ * An anonymous range one page longer than the file is reserved, and the file is mapped
+ * over its start, so the string can be passed anywhere a null-terminated string is
+ * expected without a byte being added to the file.
+ *
+ * @return 1 on success, 0 if the file cannot be mapped.
+ */
+static int map_result(int fd, size_t length, MappedString* result) { // read-only view of the output
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t file_pages = (length + page - 1) / page * page;
+
+    char* base = mmap(NULL, file_pages + page, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        return 0;
+    }
+
+    if (length > 0 && mmap(base, length, PROT_READ, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, file_pages + page);
+        return 0;
+    }
+
+    result->data = base;
+    result->length = length;
+    result->mapped_size = file_pages + page;
+    return 1;
+}
+
+/**
+ * @brief Out-of-core parser function, which writes the parsed string to a file instead of memory.
+ *
+ * This function produces the same string as `parser()`, but streams it into a file on
+ * local disk through memory-mapped windows of `OUT_OF_CORE_WINDOW` bytes. The
+ * depth-first stream needs no generation buffers, so the only memory used is the
+ * stream's frame stack and the current window, and strings far larger than RAM can be
+ * produced. The file holds exactly the parsed symbols, with no terminator, and is
+ * left in place for downstream tools.
+ *
+ * @param axiom The axiom string.
+ * @param rules The set of rules to apply.
+ * @param iterations The number of iterations to apply the rules.
+ * @param path The file to write. It is created or truncated, and removed again on failure.
+ * @param result If not NULL, filled with a read-only mapping of the file, to free with `mapped_string_free()`.
+ *
+ * @return 1 on success, 0 if the length overflows size_t or the file cannot be written or mapped.
+ */
+int parser_to_file(const char* axiom, Rule rules[], int iterations, const char* path, MappedString* result) { // expand onto disk
+    size_t length;
+    if (!calculate_parsed_length(axiom, rules, iterations, &length)) {
+        return 0;
+    }
+
+    LStream stream;
+    if (!stream_init(&stream, axiom, rules, iterations)) {
+        return 0;
+    }
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        stream_free(&stream);
+        return 0;
+    }
+
+    double span = trace_begin();
+    int ok = ftruncate(fd, (off_t)length) == 0 && write_windows(fd, &stream, length); // sized up front, still sparse
+    trace_end("expand_to_file", span, "bytes", (double)length);
+    stream_free(&stream);
+
+    if (ok && result) {
+        ok = map_result(fd, length, result);
+    }
+
+    close(fd); // a mapping outlives its descriptor
+    if (!ok) {
+        unlink(path);
+    }
+
+    return ok;
+}
+
+/**
+ * @brief Unmaps a string from `parser_to_file()`. The file itself is kept.
+ *
+ * @param string The mapped string.
+ */
+void mapped_string_free(MappedString* string) { // release the view
+    if (string->data) {
+        munmap((void*)string->data, string->mapped_size);
+    }
+
+    string->data = NULL;
+    string->length = 0;
+    string->mapped_size = 0;
+}
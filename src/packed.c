@@ -0,0 +1,192 @@
+#include "packed.h"
+#include "parser.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Adds a symbol to an alphabet if it is not already in it.
+ */
+static void add_symbol(PackedAlphabet* alphabet, unsigned char c) { // next free code
+    if (alphabet->code[c] == 0xFF && alphabet->count < 256) {
+        alphabet->code[c] = (unsigned char)alphabet->count;
+        alphabet->symbol[alphabet->count++] = (char)c;
+    }
+}
+
+/**
+ * @brief Gathers the alphabet of a grammar and picks its code width.
+ *
+ * Every symbol of the axiom and of every rule body gets a code, in order of first
+ * appearance. Grammars with at most `PACKED_NIBBLE_CODES` symbols, which covers a few
+ * letters plus "+-[]", get 4-bit codes; larger ones fall back to 8-bit codes.
+ *
+ * @param alphabet The alphabet to fill.
+ * @param axiom The axiom string.
+ * @param rules The set of rules, terminated by a rule with a '\0' character.
+ *
+ * @return The code width, 4 or 8.
+ */
+int packed_alphabet_build(PackedAlphabet* alphabet, const char* axiom, Rule rules[]) { // assign codes
+    memset(alphabet->code, 0xFF, sizeof(alphabet->code));
+    memset(alphabet->symbol, 0, sizeof(alphabet->symbol));
+    alphabet->count = 0;
+
+    for (size_t i = 0; axiom[i] != '\0'; i++) {
+        add_symbol(alphabet, (unsigned char)axiom[i]);
+    }
+    for (int r = 0; rules[r].character != '\0'; r++) {
+        for (size_t i = 0; rules[r].rule[i] != '\0'; i++) {
+            add_symbol(alphabet, (unsigned char)rules[r].rule[i]);
+        }
+    }
+
+    alphabet->bits = alphabet->count <= PACKED_NIBBLE_CODES ? 4 : 8;
+
+    for (int byte = 0; byte < 256; byte++) { // both symbols of every byte, low nibble first
+        alphabet->pair[byte][0] = alphabet->symbol[byte & 0xF];
+        alphabet->pair[byte][1] = alphabet->symbol[byte >> 4];
+    }
+
+    return alphabet->bits;
+}
+
+/**
+ * @brief Calculates the bytes needed to hold a number of symbols, including `PACKED_PADDING`.
+ *
+ * @param alphabet The alphabet, which gives the code width.
+ * @param symbols The number of symbols.
+ * @param bytes Set to the size of the buffer.
+ *
+ * @return 1 on success, 0 if the size overflows size_t.
+ */
+int packed_size(const PackedAlphabet* alphabet, size_t symbols, size_t* bytes) { // packed buffer size
+    if (symbols > (size_t)-1 - PACKED_PADDING - 1) {
+        return 0;
+    }
+
+    *bytes = (alphabet->bits == 4 ? symbols / 2 + symbols % 2 : symbols) + PACKED_PADDING;
+    return 1;
+}
+
+/**
+ * @brief Packs a run of symbols, which must all be in the alphabet.
+ *
+ * @param alphabet The alphabet to encode with.
+ * @param symbols The symbols to pack.
+ * @param count The number of symbols.
+ * @param data The packed buffer to write, starting at its first symbol.
+ */
+void packed_encode(const PackedAlphabet* alphabet, const char* symbols, size_t count, unsigned char* data) { // chars to codes
+    for (size_t i = 0; i < count; i++) {
+        unsigned char code = alphabet->code[(unsigned char)symbols[i]];
+
+        if (alphabet->bits == 8) {
+            data[i] = code;
+        } else if (i % 2 == 0) {
+            data[i / 2] = code;
+        } else {
+            data[i / 2] |= code << 4;
+        }
+    }
+}
+
+/**
+ * @brief Unpacks a range of a packed string back into symbols.
+ *
+ * 4-bit strings are decoded a byte, two symbols, at a time through the alphabet's pair table.
+ *
+ * @param string The packed string.
+ * @param start The index of the first symbol to decode.
+ * @param count The number of symbols to decode.
+ * @param symbols The buffer to write the symbols to, not null-terminated.
+ */
+void packed_decode(const PackedString* string, size_t start, size_t count, char* symbols) { // codes to chars
+    const PackedAlphabet* alphabet = &string->alphabet;
+    const unsigned char* data = string->data;
+    size_t i = 0;
+
+    if (alphabet->bits == 8) {
+        for (; i < count; i++) {
+            symbols[i] = alphabet->symbol[data[start + i]];
+        }
+        return;
+    }
+
+    if (start % 2 == 1 && count > 0) { // finish the byte the range starts in
+        symbols[i++] = alphabet->symbol[data[start / 2] >> 4];
+    }
+    for (; i + 2 <= count; i += 2) {
+        memcpy(symbols + i, alphabet->pair[data[(start + i) / 2]], 2);
+    }
+    if (i < count) {
+        symbols[i] = alphabet->symbol[data[(start + i) / 2] & 0xF];
+    }
+}
+
+/**
+ * @brief Packs the expansion of every symbol of the alphabet at its code width.
+ *
+ * Each body is stored as little-endian 64-bit words of codes, the form the packed
+ * expansion kernel appends to its output, so expanding a symbol never touches its
+ * characters. The code width divides 64, so no code straddles two words. For 4-bit
+ * alphabets the expansion of every byte, both of its codes one after the other, is
+ * packed as well, so the kernel appends a whole byte's expansion in one step.
+ *
+ * @param packed The packed rules to fill.
+ * @param table The compiled rule table, which decides which rule each symbol uses.
+ * @param alphabet The alphabet of the grammar.
+ */
+void packed_rules_compile(PackedRules* packed, const RuleTable* table, const PackedAlphabet* alphabet) { // bodies as code words
+    memset(packed->body, 0, sizeof(packed->body));
+    memset(packed->length, 0, sizeof(packed->length));
+    memset(packed->has_rule, 0, sizeof(packed->has_rule));
+    memset(packed->pair_body, 0, sizeof(packed->pair_body));
+    memset(packed->pair_length, 0, sizeof(packed->pair_length));
+
+    for (int code = 0; code < alphabet->count; code++) {
+        unsigned char c = (unsigned char)alphabet->symbol[code];
+        packed->has_rule[code] = table->has_rule[c];
+        packed->length[code] = table->length[c]; // 1 for symbols without a rule, which expand to themselves
+
+        for (size_t i = 0; i < table->length[c]; i++) {
+            size_t bit = i * alphabet->bits;
+            uint64_t symbol_code = alphabet->code[(unsigned char)table->expansion[c][i]];
+            packed->body[code][bit / 64] |= symbol_code << (bit % 64);
+        }
+    }
+
+    if (alphabet->bits != 4) {
+        return;
+    }
+
+    for (int byte = 0; byte < 256; byte++) { // the low code's expansion, then the high code's
+        int low = byte & 0xF, high = byte >> 4;
+        if (low >= alphabet->count || high >= alphabet->count) {
+            continue;
+        }
+
+        size_t length = 0;
+        for (int half = 0; half < 2; half++) {
+            int code = half ? high : low;
+
+            for (size_t i = 0; i < packed->length[code]; i++, length++) {
+                uint64_t symbol_code = (packed->body[code][i / 16] >> (i % 16 * 4)) & 0xF;
+                packed->pair_body[byte][length / 16] |= symbol_code << (length % 16 * 4);
+            }
+        }
+        packed->pair_length[byte] = length;
+    }
+}
+
+/**
+ * @brief Frees a packed string from `parser_packed()`.
+ *
+ * @param string The packed string.
+ */
+void packed_string_free(PackedString* string) { // release the packed buffer
+    buffer_release((char*)string->data);
+    string->data = NULL;
+    string->length = 0;
+}
@@ -0,0 +1,224 @@
+#include "parallel.h"
+#include "length.h"
+#include "parser.h"
+#include "scan.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+typedef struct {
+    const char* source;
+    size_t source_length;
+    char* destination;
+    const RuleTable* table;
+    size_t expanded_length;
+} ParallelSlice; // one thread's share of a generation: its input range, its output offset, and its expanded length
+
+/**
+ * @brief Counts how long one slice of the current generation becomes after one iteration.
+ *
+ * @param arg The ParallelSlice to count. Its `expanded_length` is filled in.
+ *
+ * @return NULL.
+ */
+static void* count_slice(void* arg) { // first pass: expanded length of one slice
+    ParallelSlice* slice = arg;
+    size_t expanded_length = 0;
+
+    for (size_t i = 0; i < slice->source_length; i++) {
+        expanded_length += slice->table->length[(unsigned char)slice->source[i]];
+    }
+
+    slice->expanded_length = expanded_length;
+    return NULL;
+}
+
+/**
+ * @brief Expands one slice of the current generation into its place in the next generation.
+ *
+ * @param arg The ParallelSlice to expand. Its `destination` must already point at the slice's output offset.
+ *
+ * @return NULL.
+ */
+static void* expand_slice(void* arg) { // second pass: write one slice at its offset
+    ParallelSlice* slice = arg;
+    char* out = slice->destination;
+
+    size_t i = 0;
+    while (i < slice->source_length) {
+        unsigned char c = (unsigned char)slice->source[i];
+
+        if (!slice->table->has_rule[c]) { // characters without a rule are copied as one run
+            size_t run = scan_constant_run(slice->source + i, slice->source_length - i, slice->table);
+            memcpy(out, slice->source + i, run);
+            out += run;
+            i += run;
+            continue;
+        }
+
+        memcpy(out, slice->table->expansion[c], slice->table->length[c]);
+        out += slice->table->length[c];
+        i++;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Runs one pass over every slice, on one thread per slice.
+ *
+ * The calling thread handles the first slice itself. If a thread cannot be
+ * created, its slice is run on the calling thread instead.
+ *
+ * @param slices The slices to process.
+ * @param count The number of slices.
+ * @param pass The function to run on each slice.
+ */
+static void run_pass(ParallelSlice* slices, int count, void* (*pass)(void*)) { // fork, run and join one pass
+    pthread_t workers[count];
+    int started[count];
+
+    for (int t = 1; t < count; t++) {
+        started[t] = pthread_create(&workers[t], NULL, pass, &slices[t]) == 0;
+        if (!started[t]) {
+            pass(&slices[t]);
+        }
+    }
+
+    pass(&slices[0]);
+
+    for (int t = 1; t < count; t++) {
+        if (started[t]) {
+            pthread_join(workers[t], NULL);
+        }
+    }
+}
+
+/**
+ * @brief Resolves a requested thread count.
+ *
+ * @param threads The requested number of threads. Zero or a negative number means one per online CPU.
+ *
+ * @return The number of threads to use, at least 1.
+ */
+int resolve_thread_count(int threads) { // pick the number of worker threads
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+
+    return threads;
+}
+
+/**
+ * @brief Apply one iteration of the L-System to the current buffer, on several threads.
+ *
+ * The current generation is split into equal slices, one per thread. Each thread first
+ * counts the expanded length of its slice. An exclusive prefix sum of those lengths
+ * gives every slice its offset in the next generation, and each thread then writes its
+ * slice straight into place, so no thread ever waits on another's output. Generations
+ * too short to give every thread `PARALLEL_MIN_CHUNK` characters use fewer threads.
+ *
+ * The next buffer must already be large enough for the result and its null terminator,
+ * for example sized with `calculate_generation_lengths()`.
+ *
+ * @param current_buffer The current state of the L-System.
+ * @param current_length The length of the current state.
+ * @param next_buffer The buffer that will store the result of applying one iteration of the L-System.
+ * @param table The compiled rule table of the L-System, from `compile_rules()`.
+ * @param threads The number of threads to use, or 0 for one per online CPU.
+ *
+ * @return The length of the next generation.
+ */
+size_t iterate_parallel(const char* current_buffer, size_t current_length, char* next_buffer, const RuleTable* table, int threads) { // one generation across threads
+    threads = resolve_thread_count(threads);
+
+    if ((size_t)threads > current_length / PARALLEL_MIN_CHUNK) { // keep slices large enough to be worth a thread
+        threads = (int)(current_length / PARALLEL_MIN_CHUNK);
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    ParallelSlice slices[threads];
+    size_t slice_length = current_length / threads;
+
+    for (int t = 0; t < threads; t++) { // split the current generation evenly
+        slices[t].source = current_buffer + t * slice_length;
+        slices[t].source_length = (t == threads - 1) ? current_length - t * slice_length : slice_length;
+        slices[t].table = table;
+    }
+
+    run_pass(slices, threads, count_slice);
+
+    size_t offset = 0;
+    for (int t = 0; t < threads; t++) { // exclusive prefix sum of the expanded lengths
+        slices[t].destination = next_buffer + offset;
+        offset += slices[t].expanded_length;
+    }
+
+    run_pass(slices, threads, expand_slice);
+
+    next_buffer[offset] = '\0'; // null-terminate the resulting string
+    return offset;
+}
+
+/**
+ * @brief Parallel parser function.
+ *
+ * This function produces the same string as `parser()`, using the "ping pong" approach
+ * of `parser_breadth_first()` with every generation expanded by `iterate_parallel()`.
+ * Both buffers are allocated once, at the size of the longest generation, and the buffer
+ * swapped out after each generation is discarded with `buffer_discard()`. Free the result
+ * with `buffer_release()`.
+ *
+ * @param axiom The axiom string.
+ * @param rules The set of rules to apply.
+ * @param iterations The number of iterations to apply the rules.
+ * @param threads The number of threads to use, or 0 for one per online CPU.
+ *
+ * @return The parsed string, or NULL if a length overflows size_t or allocation fails.
+ */
+char* parser_parallel(const char* axiom, Rule rules[], int iterations, int threads) { // multi-threaded parser function
+    size_t buffer_size;
+    if (!calculate_buffer_size(axiom, rules, iterations, &buffer_size)) { // size both buffers for the longest generation
+        return NULL;
+    }
+
+    RuleTable table;
+    if (!compile_rules(&table, rules)) {
+        return NULL;
+    }
+
+    char* current_buffer;
+    char* next_buffer; // "ping pong" approach
+
+    if (!buffer_allocate(&current_buffer, &next_buffer, buffer_size)) { // allocate both buffers
+        free_rule_table(&table);
+        return NULL;
+    }
+
+    strcpy(current_buffer, axiom);
+    size_t current_length = strlen(axiom);
+
+    for (int iteration = 0; iteration < iterations; iteration++) { // loop through the number of iterations
+        double span = trace_begin();
+        current_length = iterate_parallel(current_buffer, current_length, next_buffer, &table, threads);
+        trace_end("iterate_parallel", span, "bytes", (double)current_length);
+        trace_counter("generation_bytes", (double)current_length);
+
+        char* temp = current_buffer;
+        current_buffer = next_buffer;
+        next_buffer = temp; // swap buffers
+        buffer_discard(next_buffer);
+    }
+
+    buffer_release(next_buffer);
+    free_rule_table(&table);
+
+    return current_buffer; // return the parsed string
+}
@@ -1,81 +1,58 @@
 #include "parser.h"
+#include "length.h"
+#include "mapped_buffer.h"
+#include "rope.h"
+#include "scan.h"
+#include "stream.h"
+#include "trace.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <ctype.h>
 #include <string.h>
+#include <stdint.h>
 #include <Python.h>
 
+BufferBackend buffer_backend = BUFFER_BACKEND_HEAP; // malloc unless asked otherwise
+
 /**
- * @brief Calculates the expected growth factor from a given rule set.
- * 
- * @param rules The array of rules to calculate the growth factor from.
+ * @brief Selects the buffer backend from the `LSYSTEM_BUFFERS` environment variable.
  * 
- * @return The calculated growth factor, which is the average length of the rules
- * in the rule set. If no rules are present, the minimum growth factor is 1.5.
+ * "mapped" selects `BUFFER_BACKEND_MAPPED` and "heap" selects `BUFFER_BACKEND_HEAP`;
+ * anything else leaves the backend unchanged. Call it before any buffer is allocated.
  */
-double calculate_growth_factor(Rule rules[]) { // calculate the expected growth from the rule set
-    double growth_factor = 0;
-    int rule_count = 0;
-    
-    for (int i = 0; rules[i].character != '\0'; i++) {
-        growth_factor += strlen(rules[i].rule); // add the length of each rule
-        rule_count++;
-    }
-    
-    if (rule_count > 0) { // calculate how many characters each rule produces
-        growth_factor = growth_factor / rule_count;
-    } else {
-        growth_factor = 1.5;
-    }
-    
-    if (growth_factor < 1.5) { // minimum growth factor if no rules are present
-        growth_factor = 1.5;
+void buffer_backend_from_env() { // pick the backend at startup
+    const char* name = getenv(BUFFER_BACKEND_ENV);
+
+    if (name && strcmp(name, "mapped") == 0) {
+        buffer_backend = BUFFER_BACKEND_MAPPED;
+    } else if (name && strcmp(name, "heap") == 0) {
+        buffer_backend = BUFFER_BACKEND_HEAP;
     }
-    
-    return growth_factor;
 }
 
 /**
- * @brief Calculates the buffer size based on the expected growth of the parsed string.
- * 
- * This function takes the length of the axiom, the growth factor, and the number of iterations
- * as parameters and returns the size of the buffer, in bytes. The buffer size is calculated
- * as the expected size of the parsed string plus one for the null terminator. If the parsed
- * string is expected to be larger than 1,000,000 bytes, the buffer size is capped at
- * 1,000,000 bytes. If the buffer size is less than 10 times the length of the axiom, the
- * buffer size is set to 10 times the length of the axiom.
- * 
- * @param axiom_len The length of the axiom string.
- * @param growth_factor The expected growth factor of the parsed string.
- * @param iterations The number of iterations to apply the growth factor.
- * 
- * @return The calculated buffer size, in bytes.
+ * @brief Allocates one buffer from the selected backend, falling back to the heap.
  */
-size_t calculate_buffer_size(size_t axiom_len, double growth_factor, int iterations) { // calculate the buffer size based on the expected growth
-    size_t parsed_string_size = axiom_len * pow(growth_factor, iterations) + 1; // calculate the expected size of the parsed string
-    size_t buffer_size;
-    
-    if (parsed_string_size > 1000000) { // set buffer size
-        buffer_size = 1000000;
-    } else {
-        buffer_size = parsed_string_size;
-    }
-    
-    if (buffer_size < axiom_len * 10) {
-        buffer_size = axiom_len * 10;
+static char* buffer_create(size_t buffer_size) { // one buffer
+    char* buffer = NULL;
+
+    if (buffer_backend == BUFFER_BACKEND_MAPPED) {
+        buffer = mapped_buffer_create(buffer_size);
     }
-    
-    return buffer_size;
+
+    return buffer ? buffer : malloc(buffer_size);
 }
 
 /**
  * @brief Allocates memory for both buffers.
  * 
  * This function allocates memory for both the current and next buffers, and assigns
- * the pointers to the allocated memory to the provided pointers. If allocation fails,
- * the function frees any allocated memory and returns 0. If allocation succeeds, the
- * function returns 1.
+ * the pointers to the allocated memory to the provided pointers. With the mapped
+ * backend each buffer is a reserved range from `mapped_buffer_create()`, which grows in
+ * place; if a range cannot be mapped, that buffer comes from malloc instead. Release
+ * the buffers with `buffer_release()`. If allocation fails, the function frees any
+ * allocated memory and returns 0. If allocation succeeds, the function returns 1.
  * 
  * @param current_buffer The pointer to store the allocated memory for the current buffer.
  * @param next_buffer The pointer to store the allocated memory for the next buffer.
@@ -84,25 +61,31 @@ size_t calculate_buffer_size(size_t axiom_len, double growth_factor, int iterati
  * @return 1 if allocation succeeds, 0 if allocation fails.
  */
 int buffer_allocate(char** current_buffer, char** next_buffer, size_t buffer_size) { // allocate memory for both buffers
-    *current_buffer = malloc(buffer_size);
-    *next_buffer = malloc(buffer_size);
+    *current_buffer = buffer_create(buffer_size);
+    *next_buffer = buffer_create(buffer_size);
+    trace_instant("buffer_allocate", "bytes", 2.0 * buffer_size);
     
     if (!(*current_buffer) || !(*next_buffer)) {
-        free(*current_buffer);
-        free(*next_buffer);
+        buffer_release(*current_buffer);
+        buffer_release(*next_buffer);
         return 0;
     }
     
     return 1; // returning 1 for success, 0 for failure
 }
 
+size_t buffer_resize_count = 0; // reallocations made by buffer_resize(), read by the benchmarks
+
 /**
  * @brief Resizes the buffer if the needed size exceeds the current buffer size.
  * 
  * This function checks whether the buffer needs to be resized based on the
  * specified needed size. If resizing is necessary, it increases the buffer size
  * by either doubling the current size or adding 1,000,000 bytes, whichever is larger,
- * and reallocates memory accordingly.
+ * and reallocates memory accordingly. A mapped buffer commits more of its reserved
+ * range instead, so it keeps its address and nothing is copied; only when the range is
+ * exhausted does it move, to the heap. Every reallocation that copies is counted in
+ * `buffer_resize_count`, which the benchmark suite reports.
  * 
  * @param buffer The buffer to be resized.
  * @param needed_size The size that the buffer needs to accommodate.
@@ -123,77 +106,100 @@ char* buffer_resize(char* buffer, size_t needed_size, size_t* buffer_size) { //
             new_size = needed_size + 1000000; // or add 1mb
         }
         
+        if (mapped_buffer_grow(buffer, new_size)) { // commit in place, no copy
+            *buffer_size = new_size;
+            trace_instant("buffer_commit", "bytes", (double)new_size);
+            return buffer;
+        }
+
+        if (mapped_buffer_owns(buffer)) { // out of reserved space, move to the heap
+            char* moved = malloc(new_size);
+            if (moved) {
+                memcpy(moved, buffer, *buffer_size);
+            }
+            mapped_buffer_release(buffer);
+            buffer = moved;
+        } else {
+            buffer = realloc(buffer, new_size); // reallocate memory
+        }
+
         *buffer_size = new_size; 
-        buffer = realloc(buffer, new_size); // reallocate memory
+        size_t resizes = __atomic_add_fetch(&buffer_resize_count, 1, __ATOMIC_RELAXED);
+        trace_instant("buffer_resize", "bytes", (double)new_size);
+        trace_counter("buffer_resizes", (double)resizes);
     }
     
     return buffer;
 }
 
+/**
+ * @brief Gives a buffer's memory back to the kernel when its contents are no longer needed.
+ * 
+ * Called on the buffer that was just swapped out of the "ping pong", which is only ever
+ * overwritten from the start. A mapped buffer's pages are released with MADV_DONTNEED
+ * while its range stays committed; heap buffers are left as they are.
+ * 
+ * @param buffer The buffer whose contents can be dropped.
+ */
+void buffer_discard(char* buffer) { // drop the old generation
+    mapped_buffer_discard(buffer);
+}
+
+/**
+ * @brief Frees a buffer from `buffer_allocate()` or `buffer_resize()`, whichever backend it came from.
+ * 
+ * @param buffer The buffer to free, or NULL.
+ */
+void buffer_release(char* buffer) { // free or unmap
+    if (!mapped_buffer_release(buffer)) {
+        free(buffer);
+    }
+}
+
 /**
  * @brief Apply one iteration of the L-System to the current buffer.
  * 
  * This function takes the current buffer, a pointer to the next buffer, the size of the next buffer,
- * an array of Rule structs, and the growth factor as parameters. It applies one iteration of the
- * L-System to the current buffer, writing the result to the next buffer. If the next buffer is not
- * large enough to accommodate the result, it is resized. The function returns 1 on success and 0 on failure.
+ * and a compiled rule table as parameters. It applies one iteration of the L-System to the current
+ * buffer, writing the result to the next buffer. Each character with a rule costs one table lookup
+ * and one memcpy, and each run of characters without a rule, found by `scan_constant_run()`, is
+ * copied with a single memcpy. Callers that size the next buffer with `calculate_generation_lengths()` never trigger a
+ * resize; otherwise the next buffer is resized as needed. The function returns 1 on success and 0 on failure.
  * 
  * @param current_buffer The current state of the L-System.
  * @param next_buffer A pointer to the buffer that will store the result of applying one iteration of the L-System.
  * @param buffer_size A pointer to the current size of the next buffer. This value will be updated to reflect the new buffer size if resizing occurs.
- * @param rules An array of Rule structs that define the L-System.
- * @param growth_factor The expected growth factor of the L-System.
+ * @param table The compiled rule table of the L-System, from `compile_rules()`.
  * 
  * @return 1 on success, 0 on failure.
  */
-int iterate(char* current_buffer, char** next_buffer, size_t* buffer_size, Rule rules[], double growth_factor) {
+int iterate(char* current_buffer, char** next_buffer, size_t* buffer_size, const RuleTable* table) {
     size_t current_buffer_len = strlen(current_buffer);
     size_t next_buffer_length = 0;
     
-    size_t needed_mem = current_buffer_len * growth_factor * 1.2; // resize the buffer if needed
-    if (*buffer_size < needed_mem) {
-        *buffer_size = needed_mem;
-        *next_buffer = realloc(*next_buffer, *buffer_size);
+    size_t i = 0;
+    while (i < current_buffer_len) { // loop through each character in current buffer
+        unsigned char c = (unsigned char)current_buffer[i];
+        const char* expansion = table->expansion[c];
+        size_t rule_length = table->length[c];
+        size_t consumed = 1;
         
-        if (!(*next_buffer)) {
-            return 0; 
-        }
-    }
-    
-    (*next_buffer)[0] = '\0';
-    
-    for (size_t i = 0; i < current_buffer_len; i++) { // loop through each character in current buffer
-        int matched = 0;
-
-        for (int j = 0; rules[j].character != '\0'; j++) { // check if each character matches any rule
-            if (current_buffer[i] == rules[j].character) {
-                size_t rule_length = strlen(rules[j].rule);
-                
-                if (next_buffer_length + rule_length >= *buffer_size - 1) { // ensure buffer is big enough
-                    *next_buffer = buffer_resize(*next_buffer, next_buffer_length + rule_length + 1, buffer_size);
-                    if (!(*next_buffer)) {
-                        return 0; 
-                    }
-                }
-                
-                memcpy(*next_buffer + next_buffer_length, rules[j].rule, rule_length); // copy the rule to the next buffer
-                next_buffer_length += rule_length;
-                matched = 1;
-                break;
-            }
+        if (!table->has_rule[c]) { // characters without a rule are copied as one run
+            expansion = current_buffer + i;
+            rule_length = scan_constant_run(expansion, current_buffer_len - i, table);
+            consumed = rule_length;
         }
         
-        if (!matched) { // if no rule for a character, copy just the character to the next buffer
-            if (next_buffer_length + 1 >= *buffer_size - 1) { // ensure buffer is big enough
-                *next_buffer = buffer_resize(*next_buffer, next_buffer_length + 2, buffer_size);
-                if (!(*next_buffer)) {
-                    return 0; 
-                }
+        if (next_buffer_length + rule_length + 1 > *buffer_size) { // ensure buffer is big enough, including the null terminator
+            *next_buffer = buffer_resize(*next_buffer, next_buffer_length + rule_length + 1, buffer_size);
+            if (!(*next_buffer)) {
+                return 0; 
             }
-            
-            (*next_buffer)[next_buffer_length] = current_buffer[i];
-            next_buffer_length++;
         }
+        
+        memcpy(*next_buffer + next_buffer_length, expansion, rule_length); // copy to the next buffer
+        next_buffer_length += rule_length;
+        i += consumed;
     }
     
     (*next_buffer)[next_buffer_length] = '\0'; // null-terminate the resulting string
@@ -203,80 +209,332 @@ int iterate(char* current_buffer, char** next_buffer, size_t* buffer_size, Rule
 /**
  * @brief Primary parser function.
  * 
+ * This function takes an axiom, a set of rules, and the number of iterations as parameters,
+ * and returns the resulting string. It is a thin wrapper around the depth-first expansion
+ * stream: the exact length of the result is calculated up front, the result buffer is
+ * allocated once at that size, and the stream writes straight into it. No intermediate
+ * generation is ever held in memory and the buffer is never reallocated. For strings too
+ * large to hold in memory at all, `parser_to_file()` streams the same expansion to disk.
+ * 
+ * @param axiom The axiom string.
+ * @param rules The set of rules to apply.
+ * @param iterations The number of iterations to apply the rules.
+ * 
+ * @return The parsed string, or NULL if the length overflows size_t or allocation fails.
+ */
+char* parser(const char* axiom, Rule rules[], int iterations) { // primary parser function
+    size_t length;
+    double span = trace_begin();
+    int predicted = calculate_parsed_length(axiom, rules, iterations, &length); // get the exact size of the result
+    trace_end("predict_length", span, "bytes", predicted ? (double)length : -1); // -1 marks an overflow
+    if (!predicted) {
+        return NULL;
+    }
+
+    LStream stream;
+    if (!stream_init(&stream, axiom, rules, iterations)) {
+        return NULL;
+    }
+
+    char* buffer = malloc(length + 1);
+    if (!buffer) {
+        stream_free(&stream);
+        return NULL;
+    }
+    trace_instant("allocate", "bytes", (double)length + 1);
+
+    span = trace_begin();
+    stream_read(&stream, buffer, length); // read the whole stream straight into the result
+    trace_end("expand", span, "bytes", (double)length);
+    buffer[length] = '\0'; // null-terminate the resulting string
+    stream_free(&stream);
+
+    return buffer; // return the parsed string
+}
+
+/**
+ * @brief Breadth-first parser function.
+ * 
  * This function takes an axiom, a set of rules, and the number of iterations as parameters.
  * It then applies the rules to the axiom the specified number of times, and returns the
  * resulting string. The function uses a "ping pong" approach, using two buffers to store the
- * current and next strings. After each iteration, the function checks if the current buffer
- * is big enough to hold the next string. If it is not, the function doubles the size of the
- * buffer and reallocates the memory. The function also swaps the buffers after each iteration.
+ * current and next strings, and swaps the buffers after each iteration. Both buffers are
+ * allocated once, at the size of the longest generation as given by `calculate_generation_lengths()`,
+ * so no iteration ever reallocates them. With the mapped backend, the buffer swapped out after each
+ * generation is discarded with `buffer_discard()`, so the old generation does not keep its memory.
+ * Free the result with `buffer_release()`.
  * 
  * @param axiom The axiom string.
  * @param rules The set of rules to apply.
  * @param iterations The number of iterations to apply the rules.
  * 
- * @return The parsed string.
+ * @return The parsed string, or NULL if a length overflows size_t or allocation fails.
  */
-char* parser(const char* axiom, Rule rules[], int iterations) { // primary parser function
-    double growth_factor = calculate_growth_factor(rules); // get the expected growth factor from the rule set
-    
-    size_t axiom_len = strlen(axiom);
-    size_t buffer_size = calculate_buffer_size(axiom_len, growth_factor, iterations); // get the starting buffer size
+char* parser_breadth_first(const char* axiom, Rule rules[], int iterations) { // generation by generation parser function
+    size_t buffer_size;
+    if (!calculate_buffer_size(axiom, rules, iterations, &buffer_size)) { // size both buffers for the longest generation
+        return NULL;
+    }
+
+    RuleTable table;
+    if (!compile_rules(&table, rules)) { // compile the rules once for every iteration
+        return NULL;
+    }
     
     char* current_buffer;
     char* next_buffer; // "ping pong" approach
     
     if (!buffer_allocate(&current_buffer, &next_buffer, buffer_size)) { // allocate both buffers
+        free_rule_table(&table);
         return NULL;
     }
     
     strcpy(current_buffer, axiom); // copy axiom to current buffer 
     
     for (int iteration = 0; iteration < iterations; iteration++) { // loop through the number of iterations
-        if (!iterate(current_buffer, &next_buffer, &buffer_size, rules, growth_factor)) {  // apply one iteration
-            free(current_buffer);
+        double span = trace_begin();
+        if (!iterate(current_buffer, &next_buffer, &buffer_size, &table)) {  // apply one iteration
+            trace_end("iterate", span, NULL, 0);
+            buffer_release(current_buffer);
+            free_rule_table(&table);
             return NULL;
         }
-        
-        size_t next_buffer_length = strlen(next_buffer); // check if current buffer is big enough
-        if (next_buffer_length + 1 > buffer_size) {
-            buffer_size = next_buffer_length * 2;
-            current_buffer = realloc(current_buffer, buffer_size);
-            
-            if (!current_buffer) {
-                free(next_buffer);
-                return NULL;
-            }
+        if (trace_enabled) { // only measure the generation when tracing, strlen is a full pass
+            size_t generation_bytes = strlen(next_buffer);
+            trace_end("iterate", span, "bytes", (double)generation_bytes);
+            trace_counter("generation_bytes", (double)generation_bytes);
         }
         
         char* temp = current_buffer;
         current_buffer = next_buffer;
         next_buffer = temp; // swap buffers
+        buffer_discard(next_buffer); // its generation is no longer needed
     }
     
-    char* result = finalize_parser(current_buffer);
-    free(next_buffer); // free the next buffer
+    buffer_release(next_buffer); // free the next buffer
+    free_rule_table(&table);
     
-    return result; // return the parsed string
+    return current_buffer; // return the parsed string
+}
+
+typedef struct {
+    unsigned char* out;
+    uint64_t word;
+    int fill;
+} PackedWriter; // appends codes to a packed buffer through a 64-bit word, stored whenever it fills
+
+/**
+ * @brief Stores a word of codes, lowest code first, whatever the byte order of the machine.
+ */
+static inline void packed_store(unsigned char* out, uint64_t word) { // one little-endian word
+    for (int k = 0; k < 8; k++) {
+        out[k] = (unsigned char)(word >> (8 * k));
+    }
 }
 
 /**
- * @brief Resizes the buffer to the final size of the parsed string.
+ * @brief Appends up to 64 bits of codes, which must have no bits set above `bits`.
+ */
+static inline void packed_put(PackedWriter* writer, uint64_t value, int bits) { // add codes to the word
+    writer->word |= value << writer->fill;
+    writer->fill += bits;
+
+    if (writer->fill >= 64) { // the word is full, store it and keep the bits that did not fit
+        packed_store(writer->out, writer->word);
+        writer->out += 8;
+        writer->fill -= 64;
+        writer->word = writer->fill ? value >> (bits - writer->fill) : 0;
+    }
+}
+
+/**
+ * @brief Appends a packed expansion of `length` codes, a word at a time.
+ *
+ * @return The number of symbols appended.
+ */
+static inline size_t packed_append(PackedWriter* writer, const uint64_t* body, size_t length, int bits) { // one expansion
+    size_t remaining = length * bits;
+
+    for (; remaining >= 64; remaining -= 64) {
+        packed_put(writer, *body++, 64);
+    }
+    if (remaining > 0) {
+        packed_put(writer, *body, (int)remaining);
+    }
+
+    return length;
+}
+
+/**
+ * @brief Apply one iteration of the L-System to a packed buffer.
  * 
- * This function takes a pointer to the parsed string as a parameter, and resizes
- * the buffer to the final size of the string. If the realloc fails, the function
- * returns the original buffer.
+ * This is `iterate()` for packed strings. It reads the current generation a byte at a
+ * time, which is two codes for 4-bit alphabets, and appends that byte's expansion as
+ * whole pre-packed words, so no symbol is ever decoded to a character. The next buffer must
+ * be sized with `packed_size()` for the next generation's length, which includes the
+ * padding the final word store needs.
  * 
- * @param buffer A pointer to the parsed string.
+ * @param current_buffer The packed current generation.
+ * @param current_length The number of symbols in the current generation.
+ * @param next_buffer The buffer to write the packed next generation to.
+ * @param rules The packed rules, from `packed_rules_compile()`.
+ * @param bits The code width, 4 or 8.
  * 
- * @return The resized buffer, or the original buffer if the realloc fails.
+ * @return The number of symbols in the next generation.
  */
-char* finalize_parser(char* buffer) {
-    size_t final_len = strlen(buffer) + 1; // calculate size of final string
-    char* result = realloc(buffer, final_len); // resize buffer to final size
-    
-    if (!result) {
-        result = buffer;
+size_t packed_iterate(const unsigned char* current_buffer, size_t current_length, unsigned char* next_buffer, const PackedRules* rules, int bits) { // packed expansion kernel
+    PackedWriter writer = {next_buffer, 0, 0};
+    size_t next_length = 0;
+    size_t i = 0;
+
+    if (bits == 4) {
+        for (; i + 2 <= current_length; i += 2) { // both codes of each byte in one step
+            unsigned char byte = current_buffer[i / 2];
+            next_length += packed_append(&writer, rules->pair_body[byte], rules->pair_length[byte], bits);
+        }
     }
-    
-    return result;
-}
\ No newline at end of file
+    for (; i < current_length; i++) {
+        unsigned char code = packed_code_at(current_buffer, bits, i);
+        next_length += packed_append(&writer, rules->body[code], rules->length[code], bits);
+    }
+
+    if (writer.fill > 0) {
+        packed_store(writer.out, writer.word); // lands in the padding
+    }
+
+    return next_length;
+}
+
+/**
+ * @brief Packed parser function.
+ * 
+ * This function produces the same string as `parser_breadth_first()`, held as 4-bit
+ * codes when the grammar has at most `PACKED_NIBBLE_CODES` symbols and as 8-bit codes
+ * otherwise. Both "ping pong" buffers come from `buffer_allocate()` at the packed size
+ * of the longest generation, so a 4-bit system needs half the memory and every
+ * generation reads and writes half the bytes. Interpret the result with
+ * `turtle_feed_packed()` or unpack any part of it with `packed_decode()`.
+ * 
+ * @param axiom The axiom string.
+ * @param rules The set of rules to apply.
+ * @param iterations The number of iterations to apply the rules.
+ * @param result The packed string to fill, to free with `packed_string_free()`.
+ * 
+ * @return 1 on success, 0 if a length overflows size_t or allocation fails.
+ */
+int parser_packed(const char* axiom, Rule rules[], int iterations, PackedString* result) { // generation by generation, packed
+    size_t buffer_size, packed_bytes;
+    int bits = packed_alphabet_build(&result->alphabet, axiom, rules);
+
+    if (!calculate_buffer_size(axiom, rules, iterations, &buffer_size) || !packed_size(&result->alphabet, buffer_size, &packed_bytes)) {
+        return 0;
+    }
+
+    RuleTable table;
+    PackedRules* packed_rules = malloc(sizeof(PackedRules));
+    if (!packed_rules || !compile_rules(&table, rules)) {
+        free(packed_rules);
+        return 0;
+    }
+    packed_rules_compile(packed_rules, &table, &result->alphabet);
+    free_rule_table(&table);
+
+    char* current_buffer;
+    char* next_buffer; // "ping pong" approach
+
+    if (!buffer_allocate(&current_buffer, &next_buffer, packed_bytes)) {
+        free(packed_rules);
+        return 0;
+    }
+
+    size_t length = strlen(axiom);
+    packed_encode(&result->alphabet, axiom, length, (unsigned char*)current_buffer);
+
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        double span = trace_begin();
+        length = packed_iterate((unsigned char*)current_buffer, length, (unsigned char*)next_buffer, packed_rules, bits);
+        trace_end("iterate_packed", span, "symbols", (double)length);
+        trace_counter("generation_bytes", (double)length * bits / 8); // packed bytes, not symbols
+
+        char* temp = current_buffer;
+        current_buffer = next_buffer;
+        next_buffer = temp; // swap buffers
+        buffer_discard(next_buffer);
+    }
+
+    buffer_release(next_buffer);
+    free(packed_rules);
+
+    result->data = (unsigned char*)current_buffer;
+    result->length = length;
+    return 1;
+}
+
+/**
+ * @brief Returns one symbol of a generation without parsing the whole system.
+ * 
+ * This function builds the per-(symbol, depth) length table of the system with
+ * `rope_build()` and descends the derivation to the index with `rope_symbol_at()`, so
+ * the cost is O(rules x iterations) and nothing proportional to the parsed string is
+ * ever allocated. To query the same system many times, build an LRope once and call
+ * `rope_symbol_at()` directly.
+ * 
+ * @param axiom The axiom string.
+ * @param rules The set of rules to apply.
+ * @param iterations The number of iterations to apply the rules.
+ * @param index The index of the symbol in the parsed string.
+ * 
+ * @return The symbol, or '\0' if the index is past the end of the parsed string or the length overflows size_t.
+ */
+char parser_symbol_at(const char* axiom, Rule rules[], int iterations, size_t index) { // random access to one symbol
+    LRope rope;
+    if (!rope_build(&rope, axiom, rules, iterations)) {
+        return '\0';
+    }
+
+    char symbol = rope_symbol_at(&rope, index);
+    rope_free(&rope);
+
+    return symbol;
+}
+
+/**
+ * @brief Returns the substring [start, end) of a generation without parsing the whole system.
+ * 
+ * Like `parser_symbol_at()`, this function descends the derivation to `start` using the
+ * per-(symbol, depth) length table, then streams only the requested window. The only
+ * allocation proportional to the output is the returned window itself.
+ * 
+ * @param axiom The axiom string.
+ * @param rules The set of rules to apply.
+ * @param iterations The number of iterations to apply the rules.
+ * @param start The index of the first symbol of the substring.
+ * @param end The index one past the last symbol of the substring. It is clamped to the length of the parsed string.
+ * 
+ * @return The null-terminated substring, which the caller must free, or NULL on failure.
+ */
+char* parser_substring(const char* axiom, Rule rules[], int iterations, size_t start, size_t end) { // random access to a window
+    LRope rope;
+    if (!rope_build(&rope, axiom, rules, iterations)) {
+        return NULL;
+    }
+
+    if (end > rope.length) {
+        end = rope.length;
+    }
+    if (start > end) {
+        start = end;
+    }
+
+    char* window = malloc(end - start + 1);
+    if (!window) {
+        rope_free(&rope);
+        return NULL;
+    }
+
+    size_t written = rope_materialize(&rope, start, end, window);
+    window[written] = '\0'; // null-terminate the substring
+    rope_free(&rope);
+
+    return window;
+}
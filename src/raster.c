@@ -0,0 +1,346 @@
+#include "raster.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+/**
+ * @brief Allocates a framebuffer filled with a background color.
+ *
+ * @param frame The framebuffer to initialize.
+ * @param width The width, in pixels.
+ * @param height The height, in pixels.
+ * @param background The color every pixel starts as.
+ *
+ * @return 1 on success, 0 if the size is invalid or allocation fails.
+ */
+int framebuffer_init(Framebuffer* frame, int width, int height, Color background) { // allocate and clear an image
+    if (width <= 0 || height <= 0) {
+        return 0;
+    }
+
+    frame->width = width;
+    frame->height = height;
+    frame->pixels = malloc((size_t)width * height * 4);
+    if (!frame->pixels) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < (size_t)width * height; i++) {
+        memcpy(frame->pixels + i * 4, &background, 4);
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Releases the pixels of a framebuffer.
+ *
+ * @param frame The framebuffer to free.
+ */
+void framebuffer_free(Framebuffer* frame) { // free the pixels
+    free(frame->pixels);
+    frame->pixels = NULL;
+}
+
+/**
+ * @brief Blends a color into one pixel with a coverage between 0 and 1.
+ */
+static void plot(Framebuffer* frame, int x, int y, Color color, double coverage) { // alpha-blend one pixel
+    if (x < 0 || y < 0 || x >= frame->width || y >= frame->height || coverage <= 0) {
+        return;
+    }
+
+    unsigned char* pixel = frame->pixels + ((size_t)y * frame->width + x) * 4;
+    double alpha = coverage * color.a / 255.0;
+
+    pixel[0] = (unsigned char)(pixel[0] + (color.r - pixel[0]) * alpha + 0.5);
+    pixel[1] = (unsigned char)(pixel[1] + (color.g - pixel[1]) * alpha + 0.5);
+    pixel[2] = (unsigned char)(pixel[2] + (color.b - pixel[2]) * alpha + 0.5);
+    if (pixel[3] < 255) {
+        pixel[3] = (unsigned char)(pixel[3] + (255 - pixel[3]) * alpha + 0.5);
+    }
+}
+
+/**
+ * @brief Draws an anti-aliased line with Xiaolin Wu's algorithm.
+ *
+ * Each step along the major axis touches two pixels, weighted by how close the ideal
+ * line passes to each, so the cost is one pass over the line's length in pixels.
+ *
+ * @param frame The framebuffer to draw into.
+ * @param x0 The x of the start point, in pixels.
+ * @param y0 The y of the start point, in pixels.
+ * @param x1 The x of the end point, in pixels.
+ * @param y1 The y of the end point, in pixels.
+ * @param color The line color.
+ */
+void draw_line(Framebuffer* frame, double x0, double y0, double x1, double y1, Color color) { // Wu's anti-aliased line
+    int steep = fabs(y1 - y0) > fabs(x1 - x0);
+    double temp;
+
+    if (steep) { // walk along y instead
+        temp = x0; x0 = y0; y0 = temp;
+        temp = x1; x1 = y1; y1 = temp;
+    }
+    if (x0 > x1) { // always walk left to right
+        temp = x0; x0 = x1; x1 = temp;
+        temp = y0; y0 = y1; y1 = temp;
+    }
+
+    double dx = x1 - x0;
+    double gradient = dx < 1e-12 ? 1.0 : (y1 - y0) / dx;
+
+    int start = (int)floor(x0 + 0.5);
+    int end = (int)floor(x1 + 0.5);
+    double y = y0 + gradient * (start - x0);
+
+    for (int x = start; x <= end; x++) {
+        int base = (int)floor(y);
+        double fraction = y - base;
+
+        if (steep) {
+            plot(frame, base, x, color, 1 - fraction);
+            plot(frame, base + 1, x, color, fraction);
+        } else {
+            plot(frame, x, base, color, 1 - fraction);
+            plot(frame, x, base + 1, color, fraction);
+        }
+
+        y += gradient;
+    }
+}
+
+/**
+ * @brief Draws packed turtle segments scaled to fit the framebuffer.
+ *
+ * The drawing is fitted the same way as the visualizer's `set_frame()` and `fitInView`:
+ * a 10% margin is added around the bounds and the result is scaled uniformly to fit,
+ * keeping the aspect ratio, and centered.
+ *
+ * @param frame The framebuffer to draw into.
+ * @param segments The segments, as x0, y0, x1, y1 float32 quadruples.
+ * @param segment_count The number of segments.
+ * @param bounds The bounds of the drawing.
+ * @param color The line color.
+ */
+void draw_segments(Framebuffer* frame, const float* segments, size_t segment_count, const Bounds* bounds, Color color) { // fit and draw every segment
+    double width = bounds->max_x - bounds->min_x;
+    double height = bounds->max_y - bounds->min_y;
+    double margin_x = width * 0.1;
+    double margin_y = height * 0.1; // calculate a 10% margin around the drawing
+
+    double scene_width = width + 2 * margin_x;
+    double scene_height = height + 2 * margin_y;
+    if (scene_width < 1e-12) scene_width = 1;
+    if (scene_height < 1e-12) scene_height = 1;
+
+    double scale = fmin((frame->width - 1) / scene_width, (frame->height - 1) / scene_height);
+    double offset_x = (frame->width - 1 - scene_width * scale) / 2 - (bounds->min_x - margin_x) * scale;
+    double offset_y = (frame->height - 1 - scene_height * scale) / 2 - (bounds->min_y - margin_y) * scale;
+
+    for (size_t i = 0; i < segment_count; i++) {
+        const float* segment = segments + i * 4;
+        draw_line(frame,
+            segment[0] * scale + offset_x, segment[1] * scale + offset_y,
+            segment[2] * scale + offset_x, segment[3] * scale + offset_y, color);
+    }
+}
+
+/**
+ * @brief Writes a framebuffer as a binary PPM (P6) file. Alpha is dropped.
+ *
+ * @param frame The framebuffer to write.
+ * @param path The file to write.
+ *
+ * @return 1 on success, 0 on failure.
+ */
+int write_ppm(const Framebuffer* frame, const char* path) { // write a P6 image
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        return 0;
+    }
+
+    unsigned char* row = malloc((size_t)frame->width * 3);
+    if (!row) {
+        fclose(file);
+        return 0;
+    }
+
+    int ok = fprintf(file, "P6\n%d %d\n255\n", frame->width, frame->height) > 0;
+
+    for (int y = 0; ok && y < frame->height; y++) { // pack each row to RGB and write it in one call
+        const unsigned char* pixels = frame->pixels + (size_t)y * frame->width * 4;
+
+        for (int x = 0; x < frame->width; x++) {
+            memcpy(row + x * 3, pixels + x * 4, 3);
+        }
+
+        ok = fwrite(row, 3, (size_t)frame->width, file) == (size_t)frame->width;
+    }
+
+    free(row);
+    return fclose(file) == 0 && ok;
+}
+
+static uint32_t crc_table[256]; // CRC-32 of every byte value, filled once by `build_crc_table()`
+static pthread_once_t crc_table_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Fills the CRC-32 table. Run through `pthread_once()`, since batch jobs write PNGs concurrently.
+ */
+static void build_crc_table(void) { // one entry per byte value
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crc_table[n] = c;
+    }
+}
+
+/**
+ * @brief Updates a running CRC-32 (as used by PNG) with some bytes.
+ */
+static uint32_t crc32_update(uint32_t crc, const unsigned char* data, size_t length) { // PNG chunk checksum
+    pthread_once(&crc_table_once, build_crc_table);
+
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
+
+/**
+ * @brief Writes a 32-bit big-endian integer into a byte array.
+ */
+static void put_u32(unsigned char* out, uint32_t value) { // network byte order
+    out[0] = (unsigned char)(value >> 24);
+    out[1] = (unsigned char)(value >> 16);
+    out[2] = (unsigned char)(value >> 8);
+    out[3] = (unsigned char)value;
+}
+
+/**
+ * @brief Writes one PNG chunk: length, type, data and CRC.
+ */
+static int write_chunk(FILE* file, const char* type, const unsigned char* data, size_t length) { // one PNG chunk
+    unsigned char header[8];
+    unsigned char footer[4];
+
+    put_u32(header, (uint32_t)length);
+    memcpy(header + 4, type, 4);
+
+    uint32_t crc = crc32_update(0, header + 4, 4);
+    crc = crc32_update(crc, data, length);
+    put_u32(footer, crc);
+
+    return fwrite(header, 1, 8, file) == 8
+        && (length == 0 || fwrite(data, 1, length, file) == length)
+        && fwrite(footer, 1, 4, file) == 4;
+}
+
+/**
+ * @brief Writes a framebuffer as an RGBA PNG file.
+ *
+ * The image data is stored in uncompressed deflate blocks, so no compression library is
+ * needed. Files are about the size of the raw pixels, which is fine for batch output
+ * that is converted or compressed downstream.
+ *
+ * @param frame The framebuffer to write.
+ * @param path The file to write.
+ *
+ * @return 1 on success, 0 on failure.
+ */
+int write_png(const Framebuffer* frame, const char* path) { // write an uncompressed PNG
+    size_t row_size = (size_t)frame->width * 4 + 1; // filter byte and pixels
+    size_t raw_size = row_size * frame->height;
+    size_t block_count = raw_size / 65535 + 1;
+    size_t idat_size = 2 + raw_size + block_count * 5 + 4; // zlib header, stored blocks, adler-32
+
+    unsigned char* idat = malloc(idat_size);
+    if (!idat) {
+        return 0;
+    }
+
+    size_t out = 0;
+    idat[out++] = 0x78;
+    idat[out++] = 0x01; // zlib header, no compression
+
+    uint32_t adler_a = 1, adler_b = 0;
+    size_t remaining = raw_size;
+    size_t position = 0; // position in the filtered image data
+
+    while (1) { // split the filtered rows into stored blocks of at most 65535 bytes
+        size_t block = remaining < 65535 ? remaining : 65535;
+        int last = block == remaining;
+
+        idat[out++] = (unsigned char)last;
+        idat[out++] = (unsigned char)(block & 0xFF);
+        idat[out++] = (unsigned char)(block >> 8);
+        idat[out++] = (unsigned char)(~block & 0xFF);
+        idat[out++] = (unsigned char)((~block >> 8) & 0xFF);
+
+        for (size_t i = 0; i < block; i++, position++) {
+            size_t column = position % row_size;
+            unsigned char byte = column == 0 ? 0 : frame->pixels[(position / row_size) * (row_size - 1) + column - 1];
+
+            idat[out++] = byte;
+            adler_a = (adler_a + byte) % 65521;
+            adler_b = (adler_b + adler_a) % 65521;
+        }
+
+        remaining -= block;
+        if (last) {
+            break;
+        }
+    }
+
+    put_u32(idat + out, (adler_b << 16) | adler_a);
+    out += 4;
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        free(idat);
+        return 0;
+    }
+
+    static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    unsigned char ihdr[13];
+    put_u32(ihdr, (uint32_t)frame->width);
+    put_u32(ihdr + 4, (uint32_t)frame->height);
+    ihdr[8] = 8; // bit depth
+    ihdr[9] = 6; // RGBA
+    ihdr[10] = ihdr[11] = ihdr[12] = 0; // deflate, adaptive filtering, no interlace
+
+    int ok = fwrite(signature, 1, 8, file) == 8
+        && write_chunk(file, "IHDR", ihdr, 13)
+        && write_chunk(file, "IDAT", idat, out)
+        && write_chunk(file, "IEND", NULL, 0);
+
+    free(idat);
+    return fclose(file) == 0 && ok;
+}
+
+/**
+ * @brief Writes a framebuffer as PNG or PPM, chosen by the file extension.
+ *
+ * @param frame The framebuffer to write.
+ * @param path The file to write. A name ending in ".ppm" is written as PPM, anything else as PNG.
+ *
+ * @return 1 on success, 0 on failure.
+ */
+int write_image(const Framebuffer* frame, const char* path) { // pick the format from the extension
+    size_t length = strlen(path);
+
+    if (length >= 4 && strcmp(path + length - 4, ".ppm") == 0) {
+        return write_ppm(frame, path);
+    }
+
+    return write_png(frame, path);
+}
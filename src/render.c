@@ -0,0 +1,124 @@
+#include "render.h"
+#include "stream.h"
+#include "turtle.h"
+#include "raster.h"
+#include "dedup.h"
+#include "trace.h"
+#include "cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Renders an L-System to an image file without Python or Qt.
+ *
+ * The system is expanded by the depth-first stream straight into the turtle interpreter,
+ * so the parsed string is never held in memory. The turtle's segments are rasterized with
+ * anti-aliased lines into an in-memory RGBA framebuffer, red on white like the visualizer,
+ * and the framebuffer is written as PNG or PPM depending on the file extension.
+ *
+ * With `dedup`, segments that retrace earlier ones are removed with `dedup_segments()`
+ * before rasterizing, so each visible line is only drawn once.
+ *
+ * The turtle's geometry is kept in the on-disk cache, so rendering a system again, at
+ * any size or path, maps its segments with `cache_load_geometry()` instead of expanding it.
+ *
+ * @param sys The L-System to render.
+ * @param width The image width, in pixels.
+ * @param height The image height, in pixels.
+ * @param path The image file to write.
+ * @param dedup Whether to remove repeated segments before drawing.
+ * @param removed Receives the number of segments removed by `dedup`. May be NULL.
+ * @param totals Receives the turtle's step counts, segments before `dedup` and bounds. May be NULL.
+ *
+ * @return 1 on success, 0 on failure.
+ */
+int render_system(L_System* sys, int width, int height, const char* path, int dedup, size_t* removed, TurtleTotals* totals) { // headless render to a file
+    Turtle turtle;
+    LStream stream;
+    CacheEntry cached;
+    int ok = 1;
+
+    turtle_init(&turtle, sys->turn_angle, sys->start_direction);
+
+    double span = trace_begin();
+    int hit = cache_load_geometry(sys, &cached);
+    if (hit) {
+        trace_end("cache_hit", span, "segments", (double)cached.segment_count);
+
+        turtle.min_x = cached.bounds.min_x;
+        turtle.max_x = cached.bounds.max_x;
+        turtle.min_y = cached.bounds.min_y;
+        turtle.max_y = cached.bounds.max_y;
+        turtle.segment_count = cached.segment_count;
+        turtle.draw_count = cached.draw_count;
+        turtle.move_count = cached.move_count;
+    } else {
+        if (!stream_init(&stream, sys->axiom, sys->rules, sys->iterations)) {
+            return 0;
+        }
+
+        span = trace_begin();
+        ok = stream_drain(&stream, turtle_consume, &turtle) && turtle_finish(&turtle); // interpret while expanding
+        stream_free(&stream);
+        trace_end("interpret", span, "segments", (double)turtle.segment_count);
+
+        if (ok) {
+            span = trace_begin();
+            if (cache_store_geometry(sys, &turtle)) {
+                trace_end("cache_store", span, "segments", (double)turtle.segment_count);
+            }
+        }
+    }
+
+    if (hit && dedup) { // the mapping is read-only, and dedup works in place
+        size_t bytes = cached.segment_count * 4 * sizeof(float);
+        turtle.segments = malloc(bytes);
+        if (turtle.segments || bytes == 0) {
+            memcpy(turtle.segments, cached.segments, bytes);
+        } else {
+            ok = 0;
+        }
+    }
+    const float* segments = hit && !dedup ? cached.segments : turtle.segments;
+
+    if (totals) {
+        turtle_totals(&turtle, turtle.segment_count, totals);
+    }
+
+    if (removed) {
+        *removed = 0;
+    }
+    if (ok && dedup) {
+        span = trace_begin();
+        Bounds drawn = {turtle.min_x, turtle.max_x, turtle.min_y, turtle.max_y};
+        ok = dedup_segments(turtle.segments, &turtle.segment_count, dedup_quantum(DEDUP_QUANTUM, &drawn), removed);
+        trace_end("dedup", span, "segments", (double)turtle.segment_count);
+    }
+
+    Framebuffer frame;
+    Color background = {255, 255, 255, 255};
+    Color plot_color = {255, 0, 0, 255};
+
+    if (ok && framebuffer_init(&frame, width, height, background)) {
+        Bounds bounds = {turtle.min_x, turtle.max_x, turtle.min_y, turtle.max_y};
+
+        span = trace_begin();
+        draw_segments(&frame, segments, turtle.segment_count, &bounds, plot_color);
+        trace_end("rasterize", span, "segments", (double)turtle.segment_count);
+
+        span = trace_begin();
+        ok = write_image(&frame, path);
+        trace_end("write_image", span, NULL, 0);
+        framebuffer_free(&frame);
+    } else {
+        ok = 0;
+    }
+
+    turtle_free(&turtle);
+    if (hit) {
+        cache_entry_free(&cached);
+    }
+    return ok;
+}
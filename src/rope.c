@@ -0,0 +1,263 @@
+#include "rope.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief Builds the compressed derivation of an L-System.
+ *
+ * Generation n is the axiom with every symbol replaced by its own expansion after n
+ * iterations, and the expansion of a symbol with d iterations left is the concatenation
+ * of the expansions of its rule body with d - 1 iterations left. So the whole string is
+ * a DAG with one node per (symbol with a rule, remaining depth) pair, and this function
+ * stores only the expanded length of each node. Memory is O(rules x iterations) no matter
+ * how long generation n is, so systems can be held far past the point where the string
+ * itself would fit in memory. Lengths are checked for size_t overflow.
+ *
+ * The axiom and rules are copied, so the caller's arrays do not need to outlive the rope.
+ *
+ * @param rope The rope to build.
+ * @param axiom The axiom string, at most SIZE - 1 characters.
+ * @param rules The set of rules, terminated by a rule with a '\0' character.
+ * @param iterations The number of iterations to apply the rules.
+ *
+ * @return 1 on success, 0 if a length overflows size_t or allocation fails.
+ */
+int rope_build(LRope* rope, const char* axiom, Rule rules[], int iterations) { // measure every (symbol, depth) node
+    if (iterations < 0 || strlen(axiom) >= SIZE) {
+        return 0;
+    }
+
+    int rule_total = 0;
+    while (rules[rule_total].character != '\0') {
+        rule_total++;
+    }
+
+    rope->rules = calloc((size_t)rule_total + 1, sizeof(Rule)); // keep a terminated copy of the rules
+    if (!rope->rules) {
+        return 0;
+    }
+    memcpy(rope->rules, rules, (size_t)rule_total * sizeof(Rule));
+
+    if (!compile_rules(&rope->table, rope->rules)) {
+        free(rope->rules);
+        return 0;
+    }
+
+    strcpy(rope->axiom, axiom);
+    rope->iterations = iterations;
+
+    int rule_count = rope->table.rule_count;
+    for (int c = 0; c < 256; c++) {
+        rope->rule_index[c] = -1;
+    }
+    for (int k = 0; k < rule_count; k++) {
+        rope->rule_index[rope->table.rule_symbols[k]] = k;
+    }
+
+    rope->node_length = malloc(((size_t)iterations + 1) * (rule_count > 0 ? rule_count : 1) * sizeof(size_t));
+    if (!rope->node_length) {
+        free_rule_table(&rope->table);
+        free(rope->rules);
+        return 0;
+    }
+
+    for (int k = 0; k < rule_count; k++) { // no iterations left, a symbol is itself
+        rope->node_length[k] = 1;
+    }
+
+    for (int depth = 1; depth <= iterations; depth++) { // each node is the sum of its children one level down
+        for (int k = 0; k < rule_count; k++) {
+            unsigned char symbol = rope->table.rule_symbols[k];
+            const char* body = rope->table.expansion[symbol];
+            size_t total = 0;
+
+            for (size_t j = 0; j < rope->table.length[symbol]; j++) {
+                size_t child = rope_symbol_length(rope, (unsigned char)body[j], depth - 1);
+
+                if (total > SIZE_MAX - 1 - child) { // overflow, leaving room for a null terminator
+                    rope_free(rope);
+                    return 0;
+                }
+                total += child;
+            }
+
+            rope->node_length[(size_t)depth * rule_count + k] = total;
+        }
+    }
+
+    size_t length = 0;
+    for (size_t i = 0; axiom[i] != '\0'; i++) { // the whole generation is the axiom at full depth
+        size_t child = rope_symbol_length(rope, (unsigned char)axiom[i], iterations);
+
+        if (length > SIZE_MAX - 1 - child) {
+            rope_free(rope);
+            return 0;
+        }
+        length += child;
+    }
+    rope->length = length;
+
+    return 1;
+}
+
+/**
+ * @brief Looks up the expanded length of one symbol.
+ *
+ * @param rope The rope to read.
+ * @param symbol The symbol to measure.
+ * @param depth The number of iterations left to apply to the symbol, from 0 to the rope's iterations.
+ *
+ * @return The length of the symbol's expansion, which is 1 for a symbol without a rule.
+ */
+size_t rope_symbol_length(const LRope* rope, unsigned char symbol, int depth) { // length of one node
+    int k = rope->rule_index[symbol];
+
+    if (k < 0) {
+        return 1;
+    }
+
+    return rope->node_length[(size_t)depth * rope->table.rule_count + k];
+}
+
+/**
+ * @brief Finds the symbol at one index of the rope's generation without expanding it.
+ *
+ * Starting from the axiom, this function steps over whole nodes by their stored length
+ * until it reaches the node that holds the index, then moves down into that node's rule
+ * body, one level per iteration. It costs O(iterations x rule length) and allocates nothing.
+ *
+ * @param rope The rope to read.
+ * @param index The index of the symbol.
+ *
+ * @return The symbol, or '\0' if the index is past the end of the generation.
+ */
+char rope_symbol_at(const LRope* rope, size_t index) { // descend to a single symbol
+    if (index >= rope->length) {
+        return '\0';
+    }
+
+    const char* body = rope->axiom;
+    size_t body_length = strlen(rope->axiom);
+    int depth = rope->iterations;
+
+    while (1) {
+        for (size_t j = 0; j < body_length; j++) {
+            unsigned char c = (unsigned char)body[j];
+            size_t length = depth == 0 ? 1 : rope_symbol_length(rope, c, depth);
+
+            if (index >= length) { // the whole node ends before the index, step over it
+                index -= length;
+                continue;
+            }
+
+            if (depth == 0 || !rope->table.has_rule[c]) { // the index is this very symbol
+                return (char)c;
+            }
+
+            body = rope->table.expansion[c]; // descend into the node that holds the index
+            body_length = rope->table.length[c];
+            depth--;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Opens an expansion stream positioned at any index of the rope's generation.
+ *
+ * This function descends the derivation from the axiom, skipping every node that ends
+ * before `start` by its stored length, and leaves the stream's frame stack exactly as if
+ * `start` symbols had already been read. Reading the stream then yields the string from
+ * `start` onward with `stream_read()` or `stream_drain()`. Positioning costs
+ * O(iterations x rule length) and the stream must be released with `stream_free()`.
+ *
+ * @param rope The rope to iterate over.
+ * @param start The index of the first symbol to read. At or past the end gives an exhausted stream.
+ * @param stream The stream to initialize.
+ *
+ * @return 1 on success, 0 if allocation fails.
+ */
+int rope_stream(const LRope* rope, size_t start, LStream* stream) { // iterator from any index
+    if (!stream_init(stream, rope->axiom, rope->rules, rope->iterations)) {
+        return 0;
+    }
+
+    if (start >= rope->length) { // nothing left to read
+        stream->top = -1;
+        return 1;
+    }
+
+    size_t skip = start;
+    while (1) {
+        StreamFrame* frame = &stream->stack[stream->top];
+        unsigned char c = (unsigned char)frame->body[frame->offset];
+        size_t length = frame->depth == 0 ? 1 : rope_symbol_length(rope, c, frame->depth);
+
+        if (skip >= length) { // the whole node ends before start, step over it
+            skip -= length;
+            frame->offset++;
+            continue;
+        }
+
+        if (frame->depth == 0 || !rope->table.has_rule[c]) { // start is this very symbol
+            break;
+        }
+
+        frame->offset++; // descend into the node that holds start, as stream_read() would
+        StreamFrame* child = &stream->stack[++stream->top];
+        child->symbol = (char)c;
+        child->depth = frame->depth - 1;
+        child->offset = 0;
+        child->body = rope->table.expansion[c];
+        child->length = rope->table.length[c];
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Writes the range [start, end) of the rope's generation into a buffer.
+ *
+ * @param rope The rope to read.
+ * @param start The index of the first symbol to write.
+ * @param end The index one past the last symbol to write. It is clamped to the length of the generation.
+ * @param out The buffer to write into, with room for `end - start` symbols. It is not null-terminated.
+ *
+ * @return The number of symbols written, or 0 if allocation fails.
+ */
+size_t rope_materialize(const LRope* rope, size_t start, size_t end, char* out) { // expand one range
+    if (end > rope->length) {
+        end = rope->length;
+    }
+
+    if (start >= end) {
+        return 0;
+    }
+
+    LStream stream;
+    if (!rope_stream(rope, start, &stream)) {
+        return 0;
+    }
+
+    size_t written = stream_read(&stream, out, end - start);
+    stream_free(&stream);
+
+    return written;
+}
+
+/**
+ * @brief Releases the memory held by a rope.
+ *
+ * @param rope The rope to free.
+ */
+void rope_free(LRope* rope) { // free the node lengths, rules and rule table
+    free(rope->node_length);
+    free(rope->rules);
+    free_rule_table(&rope->table);
+    rope->node_length = NULL;
+    rope->rules = NULL;
+    rope->length = 0;
+}
@@ -0,0 +1,78 @@
+#include "rule_table.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Compiles a rule set into a byte-indexed expansion table.
+ *
+ * Every one of the 256 byte values gets an entry: symbols with a rule point at their
+ * rule body, and symbols without one point at a single copy of themselves. All of
+ * these strings live in one contiguous arena, allocated once. Expanding a symbol is
+ * then a single table lookup and a single memcpy, with no search through the rules and
+ * no strlen. If a character has more than one rule, the first one wins, matching
+ * the order the rules were entered in.
+ *
+ * @param table The table to compile into.
+ * @param rules The set of rules, terminated by a rule with a '\0' character.
+ *
+ * @return 1 on success, 0 if allocation fails.
+ */
+int compile_rules(RuleTable* table, Rule rules[]) { // build the lookup table and its string arena
+    size_t arena_size = 256; // one identity byte for every symbol
+
+    memset(table->has_rule, 0, sizeof(table->has_rule));
+
+    for (int i = 0; rules[i].character != '\0'; i++) { // measure the rule bodies that will be used
+        unsigned char c = (unsigned char)rules[i].character;
+
+        if (!table->has_rule[c]) {
+            table->has_rule[c] = 1;
+            table->length[c] = strlen(rules[i].rule);
+            arena_size += table->length[c];
+        }
+    }
+
+    table->arena = malloc(arena_size);
+    if (!table->arena) {
+        return 0;
+    }
+
+    char* cursor = table->arena + 256;
+    memset(table->has_rule, 0, sizeof(table->has_rule));
+    table->rule_count = 0;
+
+    for (int i = 0; rules[i].character != '\0'; i++) { // copy each first rule body into the arena
+        unsigned char c = (unsigned char)rules[i].character;
+
+        if (!table->has_rule[c]) {
+            table->has_rule[c] = 1;
+            table->rule_symbols[table->rule_count++] = c; // list of symbols with a rule, for the run scanners
+            memcpy(cursor, rules[i].rule, table->length[c]);
+            table->expansion[c] = cursor;
+            cursor += table->length[c];
+        }
+    }
+
+    for (int c = 0; c < 256; c++) { // symbols without a rule expand to themselves
+        table->arena[c] = (char)c;
+
+        if (!table->has_rule[c]) {
+            table->expansion[c] = table->arena + c;
+            table->length[c] = 1;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Releases the arena held by a compiled rule table.
+ *
+ * @param table The table to free.
+ */
+void free_rule_table(RuleTable* table) { // free the string arena
+    free(table->arena);
+    table->arena = NULL;
+}
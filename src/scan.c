@@ -0,0 +1,159 @@
+#include "scan.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCAN_X86 1
+#endif
+
+/**
+ * @brief Scalar scanner, used on every platform and for the tail of a vector scan.
+ *
+ * @param buffer The symbols to scan.
+ * @param length The number of symbols to scan.
+ * @param table The compiled rule table.
+ *
+ * @return The number of leading symbols without a rule.
+ */
+static size_t scan_scalar(const char* buffer, size_t length, const RuleTable* table) { // one byte at a time
+    size_t i = 0;
+
+    while (i < length && !table->has_rule[(unsigned char)buffer[i]]) {
+        i++;
+    }
+
+    return i;
+}
+
+#ifdef SCAN_X86
+
+/**
+ * @brief SSE2 scanner: compares 16 symbols at a time against every symbol with a rule.
+ *
+ * @param buffer The symbols to scan.
+ * @param length The number of symbols to scan.
+ * @param table The compiled rule table, with at most `SCAN_MAX_RULE_SYMBOLS` symbols with rules.
+ *
+ * @return The number of leading symbols without a rule.
+ */
+__attribute__((target("sse2")))
+static size_t scan_sse2(const char* buffer, size_t length, const RuleTable* table) { // 16 bytes per step
+    __m128i needles[SCAN_MAX_RULE_SYMBOLS];
+    for (int k = 0; k < table->rule_count; k++) {
+        needles[k] = _mm_set1_epi8((char)table->rule_symbols[k]);
+    }
+
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(buffer + i));
+        __m128i hits = _mm_setzero_si128();
+
+        for (int k = 0; k < table->rule_count; k++) {
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, needles[k]));
+        }
+
+        int mask = _mm_movemask_epi8(hits);
+        if (mask) { // the lowest set bit is the first symbol with a rule
+            return i + (size_t)__builtin_ctz((unsigned)mask);
+        }
+    }
+
+    return i + scan_scalar(buffer + i, length - i, table);
+}
+
+/**
+ * @brief AVX2 scanner: compares 32 symbols at a time against every symbol with a rule.
+ *
+ * @param buffer The symbols to scan.
+ * @param length The number of symbols to scan.
+ * @param table The compiled rule table, with at most `SCAN_MAX_RULE_SYMBOLS` symbols with rules.
+ *
+ * @return The number of leading symbols without a rule.
+ */
+__attribute__((target("avx2")))
+static size_t scan_avx2(const char* buffer, size_t length, const RuleTable* table) { // 32 bytes per step
+    __m256i needles[SCAN_MAX_RULE_SYMBOLS];
+    for (int k = 0; k < table->rule_count; k++) {
+        needles[k] = _mm256_set1_epi8((char)table->rule_symbols[k]);
+    }
+
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(buffer + i));
+        __m256i hits = _mm256_setzero_si256();
+
+        for (int k = 0; k < table->rule_count; k++) {
+            hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(block, needles[k]));
+        }
+
+        unsigned mask = (unsigned)_mm256_movemask_epi8(hits);
+        if (mask) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+
+    return i + scan_scalar(buffer + i, length - i, table);
+}
+
+#endif
+
+static RunScanner vector_scanner = scan_scalar;
+static const char* vector_scanner_name = "scalar";
+static pthread_once_t scanner_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Picks the widest vector scanner the CPU supports. Runs once per process.
+ */
+static void select_scanner() { // runtime CPU feature detection
+#ifdef SCAN_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) {
+        vector_scanner = scan_avx2;
+        vector_scanner_name = "avx2";
+    } else if (__builtin_cpu_supports("sse2")) {
+        vector_scanner = scan_sse2;
+        vector_scanner_name = "sse2";
+    }
+#endif
+}
+
+/**
+ * @brief Measures a long run of symbols without a rule.
+ *
+ * Symbols without a rule are copied through unchanged by an iteration, so a run of
+ * them can be copied with a single memcpy. This function finds where the run ends,
+ * using the widest vector kernel the CPU supports (AVX2, then SSE2, chosen once at
+ * runtime) and falling back to a scalar loop on other platforms or when the rule set
+ * has more than `SCAN_MAX_RULE_SYMBOLS` symbols with rules. Call it through
+ * `scan_constant_run()`, which handles short runs without the vector setup.
+ *
+ * @param buffer The symbols to scan.
+ * @param length The number of symbols to scan.
+ * @param table The compiled rule table.
+ *
+ * @return The number of leading symbols without a rule, from 0 to `length`.
+ */
+size_t scan_long_run(const char* buffer, size_t length, const RuleTable* table) { // vector scan of a long pass-through run
+    pthread_once(&scanner_once, select_scanner);
+
+    if (table->rule_count > SCAN_MAX_RULE_SYMBOLS) {
+        return scan_scalar(buffer, length, table);
+    }
+
+    return vector_scanner(buffer, length, table);
+}
+
+/**
+ * @brief Names the scanner kernel selected for this CPU.
+ *
+ * @return "avx2", "sse2", or "scalar".
+ */
+const char* scanner_name() { // report the selected kernel
+    pthread_once(&scanner_once, select_scanner);
+    return vector_scanner_name;
+}
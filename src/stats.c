@@ -0,0 +1,345 @@
+#include "stats.h"
+#include "length.h"
+#include "rule_table.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+
+#define NO_PATH INT64_MIN // max-plus "minus infinity": the symbol never appears in the expansion
+
+/**
+ * @brief Multiplies two counts, saturating at `STAT_COUNT_MAX`.
+ */
+static StatCount saturating_multiply(StatCount a, StatCount b) { // a * b, clamped
+    StatCount product;
+    return __builtin_mul_overflow(a, b, &product) ? STAT_COUNT_MAX : product;
+}
+
+/**
+ * @brief Adds two counts, saturating at `STAT_COUNT_MAX`.
+ */
+static StatCount saturating_add(StatCount a, StatCount b) { // a + b, clamped
+    StatCount sum;
+    return __builtin_add_overflow(a, b, &sum) ? STAT_COUNT_MAX : sum;
+}
+
+/**
+ * @brief Multiplies two square count matrices: result = a * b. The result must not alias either input.
+ */
+static void count_matrix_multiply(const StatCount* a, const StatCount* b, StatCount* result, int size) { // one squaring step
+    for (int i = 0; i < size; i++) {
+        for (int j = 0; j < size; j++) {
+            StatCount sum = 0;
+
+            for (int k = 0; k < size; k++) {
+                if (a[i * size + k] && b[k * size + j]) {
+                    sum = saturating_add(sum, saturating_multiply(a[i * size + k], b[k * size + j]));
+                }
+            }
+
+            result[i * size + j] = sum;
+        }
+    }
+}
+
+/**
+ * @brief Multiplies a row vector by a square count matrix: result = vector * matrix. The result must not alias the vector.
+ */
+static void count_vector_multiply(const StatCount* vector, const StatCount* matrix, StatCount* result, int size) { // apply a power to the counts
+    for (int j = 0; j < size; j++) {
+        StatCount sum = 0;
+
+        for (int k = 0; k < size; k++) {
+            if (vector[k] && matrix[k * size + j]) {
+                sum = saturating_add(sum, saturating_multiply(vector[k], matrix[k * size + j]));
+            }
+        }
+
+        result[j] = sum;
+    }
+}
+
+/**
+ * @brief Multiplies two square matrices in max-plus algebra: result[i][j] = max over k of a[i][k] + b[k][j].
+ */
+static void depth_matrix_multiply(const long long* a, const long long* b, long long* result, int size) { // one squaring step
+    for (int i = 0; i < size; i++) {
+        for (int j = 0; j < size; j++) {
+            long long best = NO_PATH;
+
+            for (int k = 0; k < size; k++) {
+                if (a[i * size + k] != NO_PATH && b[k * size + j] != NO_PATH && a[i * size + k] + b[k * size + j] > best) {
+                    best = a[i * size + k] + b[k * size + j];
+                }
+            }
+
+            result[i * size + j] = best;
+        }
+    }
+}
+
+/**
+ * @brief Multiplies a square matrix by a column vector in max-plus algebra. The result must not alias the vector.
+ */
+static void depth_vector_multiply(const long long* matrix, const long long* vector, long long* result, int size) { // apply a power to the depths
+    for (int i = 0; i < size; i++) {
+        long long best = NO_PATH;
+
+        for (int k = 0; k < size; k++) {
+            if (matrix[i * size + k] != NO_PATH && vector[k] != NO_PATH && matrix[i * size + k] + vector[k] > best) {
+                best = matrix[i * size + k] + vector[k];
+            }
+        }
+
+        result[i] = best;
+    }
+}
+
+/**
+ * @brief The change in bracket depth of one symbol.
+ */
+static int bracket_net(unsigned char c) { // '[' opens, ']' closes
+    return c == '[' ? 1 : (c == ']' ? -1 : 0);
+}
+
+/**
+ * @brief Calculates the deepest bracket nesting of a generation, by exponentiation in max-plus algebra.
+ *
+ * When every symbol expands to a string with the same net bracket change as itself,
+ * as it does whenever '[' and ']' have no rules and every rule body is balanced, the
+ * depth at each point of an expansion no longer depends on the generation. The deepest
+ * point reached inside the expansion of `s` after n+1 iterations is then the maximum,
+ * over the symbols `b` of its rule body, of the depth before `b` plus the deepest
+ * point inside `b` after n iterations. That recurrence is linear in max-plus algebra,
+ * so it is raised to the n-th power by squaring, like the counts.
+ *
+ * @return The deepest nesting, or -1 if the brackets are unbalanced in a way this cannot follow, or allocation fails.
+ */
+static long long calculate_max_depth(const TransitionMatrix* alphabet, const RuleTable* table, const char* axiom, unsigned long long iterations) { // deepest '[' nesting
+    int size = alphabet->size;
+    long long* cells = malloc(((size_t)size * size * 2 + (size_t)size * 2) * sizeof(long long));
+    if (!cells) {
+        return -1;
+    }
+
+    long long* power = cells;
+    long long* scratch = cells + (size_t)size * size;
+    long long* depths = scratch + (size_t)size * size;
+    long long* next_depths = depths + size;
+
+    for (int from = 0; from < size; from++) { // one step: the depth before each symbol of the expansion
+        unsigned char c = alphabet->symbols[from];
+        long long depth = 0;
+
+        for (int to = 0; to < size; to++) {
+            power[from * size + to] = NO_PATH;
+        }
+
+        for (size_t i = 0; i < table->length[c]; i++) {
+            unsigned char b = (unsigned char)table->expansion[c][i];
+            long long* cell = &power[from * size + alphabet->index_of[b]];
+
+            if (depth > *cell) {
+                *cell = depth;
+            }
+            depth += bracket_net(b);
+        }
+
+        if (depth != bracket_net(c)) { // the net change would vary between generations
+            free(cells);
+            return -1;
+        }
+
+        depths[from] = bracket_net(c) > 0 ? 1 : 0; // a lone symbol only reaches depth 1 if it opens a bracket
+    }
+
+    for (unsigned long long n = iterations; n > 0; n >>= 1) { // depths = power^iterations applied to the single-symbol depths
+        if (n & 1) {
+            depth_vector_multiply(power, depths, next_depths, size);
+            memcpy(depths, next_depths, (size_t)size * sizeof(long long));
+        }
+        if (n > 1) {
+            depth_matrix_multiply(power, power, scratch, size);
+            memcpy(power, scratch, (size_t)size * size * sizeof(long long));
+        }
+    }
+
+    long long depth = 0, deepest = 0;
+    for (size_t i = 0; axiom[i] != '\0'; i++) { // the axiom strings its expansions together
+        unsigned char c = (unsigned char)axiom[i];
+        long long inside = depths[alphabet->index_of[c]];
+
+        if (inside != NO_PATH && depth + inside > deepest) {
+            deepest = depth + inside;
+        }
+        depth += bracket_net(c);
+    }
+
+    free(cells);
+    return deepest;
+}
+
+/**
+ * @brief Calculates the statistics of a generation without expanding it.
+ *
+ * The symbol counts of the axiom are multiplied by the n-th power of the grammar's
+ * transition matrix, from `build_transition_matrix()`, computed by exponentiation by
+ * squaring. The cost is O(alphabet^3 x log(iterations)), so even a billion iterations
+ * take microseconds. Counts are 128-bit and saturate instead of wrapping: a count of
+ * `STAT_COUNT_MAX` means at least that many, and sets `saturated`. The length, draws
+ * (uppercase letters, each one segment), moves (lowercase letters), turns, pushes and
+ * pops are sums of the counts, and the deepest bracket nesting is calculated by
+ * `calculate_max_depth()`.
+ *
+ * @param axiom The axiom string.
+ * @param rules The set of rules to apply.
+ * @param iterations The number of iterations to apply the rules.
+ * @param stats The statistics to fill.
+ *
+ * @return 1 on success, 0 if allocation fails.
+ */
+int calculate_stats(const char* axiom, Rule rules[], unsigned long long iterations, SystemStats* stats) { // counts by matrix exponentiation
+    TransitionMatrix matrix;
+    RuleTable table;
+
+    if (!build_transition_matrix(&matrix, axiom, rules)) {
+        return 0;
+    }
+    if (!compile_rules(&table, rules)) {
+        free_transition_matrix(&matrix);
+        return 0;
+    }
+
+    int size = matrix.size;
+    StatCount* cells = malloc(((size_t)size * size * 2 + (size_t)size) * sizeof(StatCount));
+    if (!cells) {
+        free_rule_table(&table);
+        free_transition_matrix(&matrix);
+        return 0;
+    }
+
+    StatCount* power = cells;
+    StatCount* scratch = cells + (size_t)size * size;
+    StatCount* next_counts = scratch + (size_t)size * size;
+
+    memset(stats, 0, sizeof(SystemStats));
+    stats->iterations = iterations;
+    stats->size = size;
+    memcpy(stats->symbols, matrix.symbols, (size_t)size);
+
+    for (size_t i = 0; i < (size_t)size * size; i++) {
+        power[i] = matrix.produces[i];
+    }
+    for (size_t i = 0; axiom[i] != '\0'; i++) {
+        stats->counts[matrix.index_of[(unsigned char)axiom[i]]]++;
+    }
+
+    for (unsigned long long n = iterations; n > 0; n >>= 1) { // counts = axiom counts * matrix^iterations
+        if (n & 1) {
+            count_vector_multiply(stats->counts, power, next_counts, size);
+            memcpy(stats->counts, next_counts, (size_t)size * sizeof(StatCount));
+        }
+        if (n > 1) {
+            count_matrix_multiply(power, power, scratch, size);
+            memcpy(power, scratch, (size_t)size * size * sizeof(StatCount));
+        }
+    }
+
+    for (int i = 0; i < size; i++) { // derive the totals from the counts
+        unsigned char c = stats->symbols[i];
+        StatCount count = stats->counts[i];
+
+        stats->length = saturating_add(stats->length, count);
+        if (isupper(c)) {
+            stats->draws = saturating_add(stats->draws, count);
+        } else if (islower(c)) {
+            stats->moves = saturating_add(stats->moves, count);
+        } else if (c == '+' || c == '-') {
+            stats->turns = saturating_add(stats->turns, count);
+        } else if (c == '[') {
+            stats->pushes = saturating_add(stats->pushes, count);
+        } else if (c == ']') {
+            stats->pops = saturating_add(stats->pops, count);
+        }
+
+        if (count == STAT_COUNT_MAX) {
+            stats->saturated = 1;
+        }
+    }
+    if (stats->length == STAT_COUNT_MAX) {
+        stats->saturated = 1;
+    }
+
+    stats->max_depth = calculate_max_depth(&matrix, &table, axiom, iterations);
+
+    free(cells);
+    free_rule_table(&table);
+    free_transition_matrix(&matrix);
+
+    return 1;
+}
+
+/**
+ * @brief Writes a count in decimal, as ">= 2^128-1" if it saturated.
+ *
+ * @param count The count.
+ * @param text A buffer of at least `STAT_COUNT_DIGITS` characters.
+ */
+void format_stat_count(StatCount count, char* text) { // 128-bit to decimal
+    char digits[STAT_COUNT_DIGITS];
+    int length = 0;
+
+    if (count == STAT_COUNT_MAX) {
+        strcpy(text, ">= 2^128-1");
+        return;
+    }
+
+    do {
+        digits[length++] = (char)('0' + (int)(count % 10));
+        count /= 10;
+    } while (count > 0);
+
+    for (int i = 0; i < length; i++) {
+        text[i] = digits[length - 1 - i];
+    }
+    text[length] = '\0';
+}
+
+/**
+ * Prints the statistics of a generation: its totals, its bracket nesting and the count of each symbol.
+ *
+ * @param stats The statistics to print.
+ */
+void print_stats(const SystemStats* stats) { // totals, then each symbol
+    char text[STAT_COUNT_DIGITS];
+
+    printf("After %llu iterations, without expanding:" "\n\t", stats->iterations);
+    format_stat_count(stats->length, text);
+    printf("Length: %s" "\n\t", text);
+    format_stat_count(stats->draws, text);
+    printf("Draw Segments: %s" "\n\t", text);
+    format_stat_count(stats->moves, text);
+    printf("Moves: %s" "\n\t", text);
+    format_stat_count(stats->turns, text);
+    printf("Turns: %s" "\n\t", text);
+    format_stat_count(stats->pushes, text);
+    printf("Brackets: %s [ and ", text);
+    format_stat_count(stats->pops, text);
+    printf("%s ]" "\n\t", text);
+
+    if (stats->max_depth >= 0) {
+        printf("Deepest Nesting: %lld" "\n\t", stats->max_depth);
+    } else {
+        printf("Deepest Nesting: unknown, the brackets are unbalanced" "\n\t");
+    }
+
+    printf("Symbol Counts: {" "\n\t\t");
+    for (int i = 0; i < stats->size; i++) {
+        format_stat_count(stats->counts[i], text);
+        printf("%c: %s" "\n\t\t", stats->symbols[i], text);
+    }
+    printf("}" "\n\n");
+}
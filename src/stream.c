@@ -0,0 +1,144 @@
+#include "stream.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Prepares a depth-first expansion stream for an L-System.
+ *
+ * This function compiles the rules into a lookup table and allocates a stack of one
+ * frame per derivation level. The axiom is pushed as the root frame with the full
+ * number of iterations remaining. The memory used by the stream is
+ * bounded by the number of iterations, no matter how long the expanded string is.
+ *
+ * @param stream The stream to initialize.
+ * @param axiom The axiom string.
+ * @param rules The set of rules to apply, terminated by a rule with a '\0' character.
+ * @param iterations The number of iterations to apply the rules.
+ *
+ * @return 1 on success, 0 on failure.
+ */
+int stream_init(LStream* stream, const char* axiom, Rule rules[], int iterations) { // setup the stream and push the axiom
+    if (iterations < 0) {
+        return 0;
+    }
+
+    if (!compile_rules(&stream->table, rules)) { // map each character to its rule body
+        return 0;
+    }
+
+    stream->stack = malloc((size_t)(iterations + 1) * sizeof(StreamFrame)); // one frame per derivation level
+    if (!stream->stack) {
+        free_rule_table(&stream->table);
+        return 0;
+    }
+
+    stream->top = 0;
+    stream->stack[0].symbol = '\0';
+    stream->stack[0].depth = iterations;
+    stream->stack[0].offset = 0;
+    stream->stack[0].body = axiom;
+    stream->stack[0].length = strlen(axiom); // the axiom is the root frame
+
+    return 1;
+}
+
+/**
+ * @brief Fills a caller-supplied chunk with the next symbols of the expanded string.
+ *
+ * This function walks the derivation depth-first. A symbol with a rule and depth
+ * remaining pushes a new frame for its rule body, and a symbol without one is
+ * emitted as it is. Frames at depth 0 hold final symbols, so they are copied
+ * as a run with a single memcpy. A frame is popped once its body is exhausted.
+ *
+ * @param stream The stream to read from.
+ * @param chunk The buffer to write the symbols into. It is not null-terminated.
+ * @param chunk_size The number of bytes available in the chunk.
+ *
+ * @return The number of symbols written. A return of 0 with a non-zero chunk size
+ * means the stream is exhausted.
+ */
+size_t stream_read(LStream* stream, char* chunk, size_t chunk_size) { // produce up to chunk_size symbols
+    size_t written = 0;
+
+    while (written < chunk_size && stream->top >= 0) {
+        StreamFrame* frame = &stream->stack[stream->top];
+
+        if (frame->offset == frame->length) { // frame exhausted, return to the parent
+            stream->top--;
+            continue;
+        }
+
+        if (frame->depth == 0) { // final symbols, copy as much of the run as fits
+            size_t run = frame->length - frame->offset;
+
+            if (run > chunk_size - written) {
+                run = chunk_size - written;
+            }
+
+            memcpy(chunk + written, frame->body + frame->offset, run);
+            frame->offset += run;
+            written += run;
+            continue;
+        }
+
+        unsigned char c = (unsigned char)frame->body[frame->offset++];
+
+        if (stream->table.has_rule[c]) { // descend into the rule body of this symbol
+            StreamFrame* child = &stream->stack[++stream->top];
+            child->symbol = (char)c;
+            child->depth = frame->depth - 1;
+            child->offset = 0;
+            child->body = stream->table.expansion[c];
+            child->length = stream->table.length[c];
+        } else {
+            chunk[written++] = (char)c; // no rule, the symbol is copied through
+        }
+    }
+
+    return written;
+}
+
+/**
+ * @brief Hands the whole expanded string to a consumer, one chunk at a time.
+ *
+ * This function reads the stream into a fixed-size chunk of `STREAM_CHUNK_SIZE`
+ * bytes and passes each filled chunk to the consumer. The consumer can stop the
+ * drain early by returning 0.
+ *
+ * @param stream The stream to drain.
+ * @param consumer The callback that receives each run of symbols.
+ * @param context A pointer passed through to the consumer unchanged.
+ *
+ * @return 1 if the stream was fully drained, 0 if the consumer stopped it or allocation failed.
+ */
+int stream_drain(LStream* stream, StreamConsumer consumer, void* context) { // feed the whole stream to a consumer
+    char* chunk = malloc(STREAM_CHUNK_SIZE);
+    if (!chunk) {
+        return 0;
+    }
+
+    size_t count;
+    while ((count = stream_read(stream, chunk, STREAM_CHUNK_SIZE)) > 0) {
+        if (!consumer(chunk, count, context)) {
+            free(chunk);
+            return 0;
+        }
+    }
+
+    free(chunk);
+    return 1;
+}
+
+/**
+ * @brief Releases the memory held by a stream.
+ *
+ * @param stream The stream to free.
+ */
+void stream_free(LStream* stream) { // free the frame stack and the rule table
+    free(stream->stack);
+    free_rule_table(&stream->table);
+    stream->stack = NULL;
+    stream->top = -1;
+}
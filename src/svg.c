@@ -0,0 +1,217 @@
+#include "svg.h"
+#include "stream.h"
+#include "turtle.h"
+#include "bounds.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Writes the buffered output to the file in one call.
+ */
+static void svg_flush(SvgWriter* writer) { // one large sequential write
+    if (writer->used > 0 && fwrite(writer->buffer, 1, writer->used, writer->file) != writer->used) {
+        writer->ok = 0;
+    }
+
+    writer->used = 0;
+}
+
+/**
+ * @brief Appends formatted text to the writer's buffer, flushing first if it might not fit.
+ */
+static void svg_printf(SvgWriter* writer, const char* format, double x, double y) { // append one coordinate pair
+    if (SVG_BUFFER_SIZE - writer->used < 64) { // longer than any coordinate pair
+        svg_flush(writer);
+    }
+
+    writer->used += (size_t)snprintf(writer->buffer + writer->used, SVG_BUFFER_SIZE - writer->used, format, x, y);
+}
+
+/**
+ * @brief Turtle sink that appends each segment to the SVG path data.
+ *
+ * A segment that continues the previous one only adds its endpoint to the current
+ * polyline. Any other segment, which comes after a '[', ']' or lowercase move, starts a
+ * new subpath with an `M` command.
+ *
+ * If the writer has a `dedup` set, a segment that was already written is skipped and
+ * counted in `removed`, and the next written segment starts a new subpath.
+ *
+ * @param segment The segment, as x0, y0, x1, y1.
+ * @param continues Whether the segment starts where the previous one ended.
+ * @param context The SvgWriter.
+ *
+ * @return 1 while writes succeed, 0 after a write error, which stops the expansion.
+ */
+int svg_segment(const float* segment, int continues, void* context) { // extend or start a polyline
+    SvgWriter* writer = context;
+    writer->segments++;
+
+    if (writer->dedup) { // drop segments that are already in the path
+        int inserted;
+
+        if (!segment_set_insert(writer->dedup, segment, &inserted)) {
+            writer->ok = 0;
+            return 0;
+        }
+
+        if (!inserted) {
+            writer->removed++;
+            writer->broken = 1;
+            return writer->ok;
+        }
+
+        if (writer->broken) { // the polyline was interrupted by a skipped segment
+            continues = 0;
+            writer->broken = 0;
+        }
+    }
+
+    if (!continues) {
+        svg_printf(writer, "M%.3f %.3f", segment[0], segment[1]);
+        svg_printf(writer, "L%.3f %.3f", segment[2], segment[3]);
+    } else {
+        svg_printf(writer, " %.3f %.3f", segment[2], segment[3]);
+    }
+
+    return writer->ok;
+}
+
+/**
+ * @brief Turtle sink that ignores segments, for the bounds-only pass.
+ */
+static int skip_segment(const float* segment, int continues, void* context) { // discard
+    (void)segment;
+    (void)continues;
+    (void)context;
+    return 1;
+}
+
+/**
+ * @brief Exports an L-System as an SVG file while it is being expanded.
+ *
+ * The system is expanded by the depth-first stream straight into a turtle whose segments
+ * go to `svg_segment()`, which writes the path data through a fixed-size buffer. Runs of
+ * draw steps become single polylines and every break in the line starts a new `M`
+ * subpath, all in one `path` element. Nothing grows with the iteration count except the
+ * turtle's bracket stack, and the set of written segments when `dedup` is on.
+ *
+ * The header needs the drawing's bounds before any path data. They come from
+ * `calculate_bounds()` when the system allows it, and otherwise from a first expansion
+ * pass through a turtle that discards its segments.
+ *
+ * @param sys The L-System to export.
+ * @param path The SVG file to write.
+ * @param dedup Whether to skip segments that retrace ones already written.
+ * @param removed Receives the number of segments skipped by `dedup`. May be NULL.
+ * @param totals Receives the turtle's step counts, segments before `dedup` and bounds. May be NULL.
+ *
+ * @return 1 on success, 0 on failure.
+ */
+int export_svg(L_System* sys, const char* path, int dedup, size_t* removed, TurtleTotals* totals) { // streaming vector export
+    Bounds bounds;
+    Turtle turtle;
+    LStream stream;
+
+    double span = trace_begin();
+    if (!calculate_bounds(sys->axiom, sys->rules, sys->iterations, sys->turn_angle, sys->start_direction, &bounds)) { // measure with a discarding turtle
+        turtle_init(&turtle, sys->turn_angle, sys->start_direction);
+        turtle.sink = skip_segment;
+
+        if (!stream_init(&stream, sys->axiom, sys->rules, sys->iterations)) {
+            trace_end("svg_bounds", span, NULL, 0);
+            return 0;
+        }
+
+        int measured = stream_drain(&stream, turtle_consume, &turtle);
+        stream_free(&stream);
+
+        bounds.min_x = turtle.min_x;
+        bounds.max_x = turtle.max_x;
+        bounds.min_y = turtle.min_y;
+        bounds.max_y = turtle.max_y;
+        turtle_free(&turtle);
+
+        if (!measured) {
+            trace_end("svg_bounds", span, NULL, 0);
+            return 0;
+        }
+    }
+
+    trace_end("svg_bounds", span, NULL, 0);
+
+    SvgWriter writer;
+    writer.file = fopen(path, "wb");
+    if (!writer.file) {
+        return 0;
+    }
+
+    writer.buffer = malloc(SVG_BUFFER_SIZE);
+    if (!writer.buffer) {
+        fclose(writer.file);
+        return 0;
+    }
+
+    SegmentSet written;
+    if (dedup && !segment_set_init(&written, dedup_quantum(DEDUP_QUANTUM, &bounds))) {
+        free(writer.buffer);
+        fclose(writer.file);
+        return 0;
+    }
+
+    setvbuf(writer.file, NULL, _IONBF, 0); // the writer already buffers, skip stdio's copy
+    writer.used = 0;
+    writer.ok = 1;
+    writer.dedup = dedup ? &written : NULL;
+    writer.segments = 0;
+    writer.removed = 0;
+    writer.broken = 0;
+
+    double width = bounds.max_x - bounds.min_x;
+    double height = bounds.max_y - bounds.min_y;
+    double margin_x = width * 0.1;
+    double margin_y = height * 0.1; // same 10% margin as the visualizer
+
+    writer.used = (size_t)snprintf(writer.buffer, SVG_BUFFER_SIZE,
+        "<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"%.3f %.3f %.3f %.3f\" width=\"800\" height=\"800\">\n"
+        "<rect x=\"%.3f\" y=\"%.3f\" width=\"%.3f\" height=\"%.3f\" fill=\"white\"/>\n"
+        "<path fill=\"none\" stroke=\"red\" stroke-width=\"1\" vector-effect=\"non-scaling-stroke\" d=\"",
+        bounds.min_x - margin_x, bounds.min_y - margin_y, width + 2 * margin_x, height + 2 * margin_y,
+        bounds.min_x - margin_x, bounds.min_y - margin_y, width + 2 * margin_x, height + 2 * margin_y);
+
+    turtle_init(&turtle, sys->turn_angle, sys->start_direction);
+    turtle.sink = svg_segment;
+    turtle.sink_context = &writer;
+
+    span = trace_begin();
+    int ok = stream_init(&stream, sys->axiom, sys->rules, sys->iterations);
+    if (ok) {
+        ok = stream_drain(&stream, turtle_consume, &turtle) && turtle_finish(&turtle); // write path data while expanding
+        stream_free(&stream);
+    }
+    trace_end("svg_write", span, "draws", (double)turtle.draw_count);
+    if (totals) {
+        turtle_totals(&turtle, writer.segments, totals);
+    }
+    turtle_free(&turtle);
+
+    if (SVG_BUFFER_SIZE - writer.used < 16) {
+        svg_flush(&writer);
+    }
+    memcpy(writer.buffer + writer.used, "\"/>\n</svg>\n", 11);
+    writer.used += 11;
+    svg_flush(&writer);
+
+    if (dedup) {
+        segment_set_free(&written);
+    }
+    if (removed) {
+        *removed = writer.removed;
+    }
+
+    free(writer.buffer);
+    return fclose(writer.file) == 0 && ok && writer.ok;
+}
@@ -0,0 +1,358 @@
+#include "tiles.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/**
+ * @brief Finds the bucket cell that holds a coordinate, clamped to the grid.
+ *
+ * @param pyramid The pyramid whose bucket grid is used.
+ * @param coordinate The x or y coordinate.
+ * @param origin The matching origin of the world square.
+ *
+ * @return The cell column or row.
+ */
+static int cell_of(const TilePyramid* pyramid, double coordinate, double origin) { // world coordinate to bucket index
+    int cell = (int)floor((coordinate - origin) / pyramid->world_size * pyramid->grid);
+
+    return cell < 0 ? 0 : cell >= pyramid->grid ? pyramid->grid - 1 : cell;
+}
+
+/**
+ * @brief Clips a line to a rectangle with the Liang-Barsky algorithm.
+ *
+ * @param line The line as x0, y0, x1, y1, shortened in place to the part inside the rectangle.
+ * @param min The low edge of the rectangle on both axes.
+ * @param max The high edge of the rectangle on both axes.
+ *
+ * @return 1 if part of the line is inside, 0 if it misses the rectangle.
+ */
+static int clip_line(double* line, double min, double max) { // keep the part of a line inside a square
+    double dx = line[2] - line[0];
+    double dy = line[3] - line[1];
+    double p[4] = {-dx, dx, -dy, dy};
+    double q[4] = {line[0] - min, max - line[0], line[1] - min, max - line[1]};
+    double enter = 0, leave = 1;
+
+    for (int i = 0; i < 4; i++) {
+        if (p[i] == 0) {
+            if (q[i] < 0) {
+                return 0; // parallel to this edge and outside it
+            }
+            continue;
+        }
+
+        double t = q[i] / p[i];
+        if (p[i] < 0 && t > enter) {
+            enter = t;
+        } else if (p[i] > 0 && t < leave) {
+            leave = t;
+        }
+    }
+
+    if (enter > leave) {
+        return 0;
+    }
+
+    double x0 = line[0], y0 = line[1];
+    line[0] = x0 + enter * dx;
+    line[1] = y0 + enter * dy;
+    line[2] = x0 + leave * dx;
+    line[3] = y0 + leave * dy;
+
+    return 1;
+}
+
+/**
+ * @brief Allocates the tile slots of a level the first time it is used.
+ *
+ * @param pyramid The pyramid.
+ * @param level The level, which has 2^level by 2^level slots.
+ *
+ * @return 1 on success, 0 if allocation fails.
+ */
+static int ensure_level(TilePyramid* pyramid, int level) { // lazily allocate a level's slots
+    if (!pyramid->tiles[level]) {
+        pyramid->tiles[level] = calloc((size_t)1 << (2 * level), sizeof(Tile*));
+    }
+
+    return pyramid->tiles[level] != NULL;
+}
+
+/**
+ * @brief Rasterizes one tile from the segments in the bucket cells it overlaps.
+ *
+ * A segment that spans several cells is listed in each of them, so every segment is
+ * stamped when drawn and skipped if it comes up again for the same tile. Segments are
+ * clipped to the tile first, which keeps the cost proportional to the visible length
+ * even when the tile is a small window into a long line.
+ *
+ * @param pyramid The pyramid.
+ * @param level The level of the tile.
+ * @param x The column of the tile.
+ * @param y The row of the tile.
+ *
+ * @return The new tile, or NULL if allocation fails.
+ */
+static Tile* render_tile(TilePyramid* pyramid, int level, int x, int y) { // rasterize one tile
+    Tile* tile = malloc(sizeof(Tile));
+    Color background = {255, 255, 255, 255};
+    Color plot_color = {255, 0, 0, 255}; // red on white, like the visualizer
+
+    if (!tile || !framebuffer_init(&tile->frame, TILE_SIZE, TILE_SIZE, background)) {
+        free(tile);
+        return NULL;
+    }
+
+    tile->level = level;
+    tile->x = x;
+    tile->y = y;
+    tile->last_used = ++pyramid->clock;
+
+    double size = pyramid->world_size / (1 << level);
+    double left = pyramid->origin_x + x * size;
+    double top = pyramid->origin_y + y * size;
+    double scale = TILE_SIZE / size;
+
+    if (++pyramid->stamp == 0) { // the stamp wrapped, forget every old mark
+        memset(pyramid->drawn, 0, pyramid->segment_count * sizeof(unsigned int));
+        pyramid->stamp = 1;
+    }
+
+    int first_column = cell_of(pyramid, left, pyramid->origin_x);
+    int last_column = cell_of(pyramid, left + size, pyramid->origin_x);
+    int first_row = cell_of(pyramid, top, pyramid->origin_y);
+    int last_row = cell_of(pyramid, top + size, pyramid->origin_y);
+
+    for (int row = first_row; row <= last_row; row++) {
+        for (int column = first_column; column <= last_column; column++) {
+            size_t cell = (size_t)row * pyramid->grid + column;
+
+            for (size_t i = pyramid->cell_start[cell]; i < pyramid->cell_start[cell + 1]; i++) {
+                size_t index = pyramid->cell_segments[i];
+                if (pyramid->drawn[index] == pyramid->stamp) {
+                    continue;
+                }
+                pyramid->drawn[index] = pyramid->stamp;
+
+                const float* segment = pyramid->segments + index * 4;
+                double line[4] = {
+                    (segment[0] - left) * scale, (segment[1] - top) * scale,
+                    (segment[2] - left) * scale, (segment[3] - top) * scale
+                };
+
+                if (clip_line(line, -1, TILE_SIZE + 1)) { // a pixel of slack so anti-aliased edges reach the border
+                    draw_line(&tile->frame, line[0], line[1], line[2], line[3], plot_color);
+                }
+            }
+        }
+    }
+
+    return tile;
+}
+
+/**
+ * @brief Builds a tile pyramid over a set of turtle segments.
+ *
+ * The world is the square around the drawing with the same 10% margin as the
+ * visualizer's `set_frame()`. Level 0 is one tile covering all of it, and each level
+ * below splits every tile into four, down to the level where one turtle step spans
+ * `TILE_MAX_ZOOM` pixels. The segments are bucketed once into a grid so a tile only
+ * visits the segments near it, the coarsest `TILE_PRERENDERED_LEVELS` levels are
+ * rasterized straight away, and finer tiles are rasterized by `tile_pyramid_get()`.
+ *
+ * The pyramid keeps a pointer to `segments`, so they must outlive it.
+ *
+ * @param pyramid The pyramid to build.
+ * @param segments The segments, as x0, y0, x1, y1 float32 quadruples.
+ * @param segment_count The number of segments.
+ * @param bounds The bounds of the drawing.
+ *
+ * @return 1 on success, 0 if allocation fails.
+ */
+int tile_pyramid_build(TilePyramid* pyramid, const float* segments, size_t segment_count, const Bounds* bounds) { // bucket the segments and prerender coarse levels
+    memset(pyramid, 0, sizeof(TilePyramid));
+    pyramid->segments = segments;
+    pyramid->segment_count = segment_count;
+
+    double side = fmax(bounds->max_x - bounds->min_x, bounds->max_y - bounds->min_y) * 1.2; // 10% margin on each side
+    if (side < 1e-12) {
+        side = 1;
+    }
+
+    pyramid->world_size = side;
+    pyramid->origin_x = (bounds->min_x + bounds->max_x) / 2 - side / 2;
+    pyramid->origin_y = (bounds->min_y + bounds->max_y) / 2 - side / 2; // center the drawing in the square
+
+    pyramid->levels = 1;
+    while (pyramid->levels < TILE_MAX_LEVELS && side / (1 << (pyramid->levels - 1)) / TILE_SIZE > 1.0 / TILE_MAX_ZOOM) {
+        pyramid->levels++;
+    }
+    pyramid->grid = 1 << (pyramid->levels - 1 < TILE_BUCKET_LEVEL ? pyramid->levels - 1 : TILE_BUCKET_LEVEL);
+
+    size_t cells = (size_t)pyramid->grid * pyramid->grid;
+    pyramid->cell_start = calloc(cells + 1, sizeof(size_t));
+    pyramid->drawn = calloc(segment_count ? segment_count : 1, sizeof(unsigned int));
+    size_t* cursor = malloc(cells * sizeof(size_t));
+
+    if (!pyramid->cell_start || !pyramid->drawn || !cursor) {
+        free(cursor);
+        tile_pyramid_free(pyramid);
+        return 0;
+    }
+
+    for (int pass = 0; pass < 2; pass++) { // count the entries of each cell, then place them
+        for (size_t i = 0; i < segment_count; i++) {
+            const float* segment = segments + i * 4;
+            int first_column = cell_of(pyramid, fmin(segment[0], segment[2]), pyramid->origin_x);
+            int last_column = cell_of(pyramid, fmax(segment[0], segment[2]), pyramid->origin_x);
+            int first_row = cell_of(pyramid, fmin(segment[1], segment[3]), pyramid->origin_y);
+            int last_row = cell_of(pyramid, fmax(segment[1], segment[3]), pyramid->origin_y);
+
+            for (int row = first_row; row <= last_row; row++) {
+                for (int column = first_column; column <= last_column; column++) {
+                    size_t cell = (size_t)row * pyramid->grid + column;
+
+                    if (pass == 0) {
+                        pyramid->cell_start[cell + 1]++;
+                    } else {
+                        pyramid->cell_segments[cursor[cell]++] = i;
+                    }
+                }
+            }
+        }
+
+        if (pass == 0) { // prefix sum the counts into start offsets
+            for (size_t cell = 0; cell < cells; cell++) {
+                pyramid->cell_start[cell + 1] += pyramid->cell_start[cell];
+            }
+            memcpy(cursor, pyramid->cell_start, cells * sizeof(size_t));
+
+            pyramid->cell_segments = malloc((pyramid->cell_start[cells] ? pyramid->cell_start[cells] : 1) * sizeof(size_t));
+            if (!pyramid->cell_segments) {
+                free(cursor);
+                tile_pyramid_free(pyramid);
+                return 0;
+            }
+        }
+    }
+    free(cursor);
+
+    for (int level = 0; level < pyramid->levels && level < TILE_PRERENDERED_LEVELS; level++) { // rasterize the coarse levels up front
+        if (!ensure_level(pyramid, level)) {
+            tile_pyramid_free(pyramid);
+            return 0;
+        }
+
+        for (int y = 0; y < 1 << level; y++) {
+            for (int x = 0; x < 1 << level; x++) {
+                Tile* tile = render_tile(pyramid, level, x, y);
+                if (!tile) {
+                    tile_pyramid_free(pyramid);
+                    return 0;
+                }
+
+                pyramid->tiles[level][((size_t)y << level) + x] = tile;
+            }
+        }
+    }
+
+    pyramid->cache = malloc(TILE_CACHE_LIMIT * sizeof(Tile*));
+    if (!pyramid->cache) {
+        tile_pyramid_free(pyramid);
+        return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Returns one tile of the pyramid, rasterizing it on first use.
+ *
+ * Tiles below the prerendered levels are kept in a cache of `TILE_CACHE_LIMIT`
+ * tiles. When it is full, the least recently returned tile is freed to make room.
+ * The returned framebuffer stays valid until `TILE_CACHE_LIMIT` more tiles have been
+ * requested or the pyramid is freed.
+ *
+ * @param pyramid The pyramid.
+ * @param level The level, from 0 to `levels - 1`.
+ * @param x The column, from 0 to 2^level - 1.
+ * @param y The row, from 0 to 2^level - 1.
+ *
+ * @return The tile's RGBA pixels, `TILE_SIZE` square, or NULL if the tile does not exist or allocation fails.
+ */
+const Framebuffer* tile_pyramid_get(TilePyramid* pyramid, int level, int x, int y) { // fetch or rasterize a tile
+    if (level < 0 || level >= pyramid->levels || x < 0 || y < 0 || x >= 1 << level || y >= 1 << level) {
+        return NULL;
+    }
+
+    if (!ensure_level(pyramid, level)) {
+        return NULL;
+    }
+
+    Tile** slot = &pyramid->tiles[level][((size_t)y << level) + x];
+    if (*slot) {
+        (*slot)->last_used = ++pyramid->clock;
+        return &(*slot)->frame;
+    }
+
+    if (pyramid->cache_count == TILE_CACHE_LIMIT) { // evict the least recently used tile
+        size_t oldest = 0;
+        for (size_t i = 1; i < pyramid->cache_count; i++) {
+            if (pyramid->cache[i]->last_used < pyramid->cache[oldest]->last_used) {
+                oldest = i;
+            }
+        }
+
+        Tile* evicted = pyramid->cache[oldest];
+        pyramid->tiles[evicted->level][((size_t)evicted->y << evicted->level) + evicted->x] = NULL;
+        framebuffer_free(&evicted->frame);
+        free(evicted);
+        pyramid->cache[oldest] = pyramid->cache[--pyramid->cache_count];
+    }
+
+    Tile* tile = render_tile(pyramid, level, x, y);
+    if (!tile) {
+        return NULL;
+    }
+
+    *slot = tile;
+    pyramid->cache[pyramid->cache_count++] = tile;
+
+    return &tile->frame;
+}
+
+/**
+ * @brief Releases every tile and the bucket grid of a pyramid.
+ *
+ * @param pyramid The pyramid to free. The segments it was built from are not freed.
+ */
+void tile_pyramid_free(TilePyramid* pyramid) { // free tiles, buckets and cache
+    for (int level = 0; level < TILE_MAX_LEVELS; level++) {
+        if (!pyramid->tiles[level]) {
+            continue;
+        }
+
+        for (size_t i = 0; i < (size_t)1 << (2 * level); i++) {
+            if (pyramid->tiles[level][i]) {
+                framebuffer_free(&pyramid->tiles[level][i]->frame);
+                free(pyramid->tiles[level][i]);
+            }
+        }
+
+        free(pyramid->tiles[level]);
+        pyramid->tiles[level] = NULL;
+    }
+
+    free(pyramid->cache);
+    free(pyramid->cell_start);
+    free(pyramid->cell_segments);
+    free(pyramid->drawn);
+    pyramid->cache = NULL;
+    pyramid->cell_start = NULL;
+    pyramid->cell_segments = NULL;
+    pyramid->drawn = NULL;
+    pyramid->cache_count = 0;
+}
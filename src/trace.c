@@ -0,0 +1,195 @@
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+int trace_enabled = 0;
+
+static TraceEvent* trace_events = NULL;
+static size_t trace_count = 0;
+static size_t trace_capacity = 0;
+static char* trace_path = NULL;
+static double trace_origin = 0;
+static int trace_threads = 0;
+static __thread int trace_thread = 0; // small per-thread id, assigned on the thread's first event
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Microseconds on the monotonic clock since the trace started.
+ */
+double trace_clock() { // trace timestamp
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3 - trace_origin;
+}
+
+/**
+ * @brief Starts recording a trace that `trace_stop()` will write to a file.
+ *
+ * Events are kept in memory while the program runs, so tracing adds no I/O to the
+ * stages it measures. The file is written when `trace_stop()` is called, which this
+ * function registers with atexit() so every exit path writes it.
+ *
+ * @param path The file to write the Chrome trace-event JSON to.
+ *
+ * @return 1 on success, 0 if a trace is already running or allocation fails.
+ */
+int trace_start(const char* path) { // begin recording
+    if (trace_enabled) {
+        return 0;
+    }
+
+    trace_path = malloc(strlen(path) + 1);
+    if (!trace_path) {
+        return 0;
+    }
+    strcpy(trace_path, path);
+
+    static int registered = 0;
+    if (!registered) {
+        atexit(trace_stop);
+        registered = 1;
+    }
+
+    trace_origin = 0;
+    trace_origin = trace_clock();
+    trace_count = 0;
+    trace_enabled = 1;
+
+    return 1;
+}
+
+/**
+ * @brief Starts a trace if the `LSYSTEM_TRACE` environment variable names a file.
+ *
+ * @return 1 if a trace was started, 0 otherwise.
+ */
+int trace_start_from_env() { // begin recording when asked to by the environment
+    const char* path = getenv(TRACE_ENV);
+
+    return path && path[0] != '\0' && trace_start(path);
+}
+
+/**
+ * @brief Appends one event to the trace.
+ *
+ * Names longer than `TRACE_NAME_SIZE - 1` are cut short. Events from several threads
+ * are recorded under a lock and keep their thread ids, so each thread gets its own
+ * track in the viewer.
+ *
+ * @param phase 'X' for a span, 'i' for an instant or 'C' for a counter.
+ * @param name The event name.
+ * @param start The start time from `trace_clock()`.
+ * @param end The end time from `trace_clock()`.
+ * @param arg_name The name of the event's numeric argument, or NULL for none.
+ * @param arg_value The argument value.
+ */
+void trace_record(char phase, const char* name, double start, double end, const char* arg_name, double arg_value) { // store one event
+    if (!trace_enabled) {
+        return;
+    }
+
+    pthread_mutex_lock(&trace_lock);
+
+    if (trace_thread == 0) {
+        trace_thread = ++trace_threads;
+    }
+
+    if (trace_count == trace_capacity) {
+        size_t capacity = trace_capacity ? trace_capacity * 2 : 4096;
+        TraceEvent* events = realloc(trace_events, capacity * sizeof(TraceEvent));
+
+        if (!events) { // drop the event rather than disturb the run
+            pthread_mutex_unlock(&trace_lock);
+            return;
+        }
+
+        trace_events = events;
+        trace_capacity = capacity;
+    }
+
+    TraceEvent* event = &trace_events[trace_count++];
+    snprintf(event->name, TRACE_NAME_SIZE, "%s", name);
+    event->phase = phase;
+    event->thread = trace_thread;
+    event->start = start;
+    event->duration = end - start;
+    snprintf(event->arg_name, TRACE_NAME_SIZE, "%s", arg_name ? arg_name : "");
+    event->arg_value = arg_value;
+
+    pthread_mutex_unlock(&trace_lock);
+}
+
+/**
+ * @brief Writes a string as a JSON string literal, escaping what needs it.
+ */
+static void write_json_string(FILE* file, const char* text) { // quote and escape
+    fputc('"', file);
+    for (size_t i = 0; text[i] != '\0'; i++) {
+        if (text[i] == '"' || text[i] == '\\') {
+            fputc('\\', file);
+        }
+        if ((unsigned char)text[i] >= 0x20) {
+            fputc(text[i], file);
+        }
+    }
+    fputc('"', file);
+}
+
+/**
+ * @brief Stops recording and writes the trace as Chrome trace-event JSON.
+ *
+ * The file loads in chrome://tracing or Perfetto. Does nothing if no trace is running.
+ */
+void trace_stop() { // write and discard the recorded events
+    if (!trace_enabled) {
+        return;
+    }
+
+    pthread_mutex_lock(&trace_lock);
+    trace_enabled = 0;
+
+    FILE* file = fopen(trace_path, "w");
+    if (file) {
+        fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+
+        for (size_t i = 0; i < trace_count; i++) {
+            const TraceEvent* event = &trace_events[i];
+
+            fprintf(file, "%s\n{\"name\": ", i ? "," : "");
+            write_json_string(file, event->name);
+            fprintf(file, ", \"ph\": \"%c\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f", event->phase, event->thread, event->start);
+
+            if (event->phase == 'X') {
+                fprintf(file, ", \"dur\": %.3f", event->duration);
+            } else if (event->phase == 'i') {
+                fprintf(file, ", \"s\": \"t\"");
+            }
+
+            if (event->arg_name[0] != '\0') {
+                fprintf(file, ", \"args\": {");
+                write_json_string(file, event->arg_name);
+                fprintf(file, ": %.17g}", event->arg_value);
+            }
+
+            fputc('}', file);
+        }
+
+        fprintf(file, "\n]}\n");
+        fclose(file);
+    } else {
+        fprintf(stderr, "ERROR: Unable to write trace to %s" "\n", trace_path);
+    }
+
+    free(trace_events);
+    free(trace_path);
+    trace_events = NULL;
+    trace_path = NULL;
+    trace_count = 0;
+    trace_capacity = 0;
+
+    pthread_mutex_unlock(&trace_lock);
+}
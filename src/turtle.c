@@ -0,0 +1,298 @@
+#include "turtle.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string.h>
+#include <math.h>
+
+/**
+ * @brief Recalculates the unit step of the turtle after its heading changes.
+ *
+ * The heading only changes on '+', '-' and ']', so the trigonometry is done here once
+ * per change instead of once per step.
+ *
+ * @param turtle The turtle to update.
+ */
+static void update_step(Turtle* turtle) { // cache the unit step for the current heading
+    double radians = turtle->state.direction * M_PI / 180.0;
+    turtle->step_x = cos(radians);
+    turtle->step_y = -sin(radians); // screen coordinates, y grows downward
+}
+
+/**
+ * @brief Widens the bounding box to include a point.
+ *
+ * @param turtle The turtle whose bounds are updated.
+ */
+static void include_point(Turtle* turtle) { // grow the bounds to the current position
+    if (turtle->state.x < turtle->min_x) turtle->min_x = turtle->state.x;
+    if (turtle->state.x > turtle->max_x) turtle->max_x = turtle->state.x;
+    if (turtle->state.y < turtle->min_y) turtle->min_y = turtle->state.y;
+    if (turtle->state.y > turtle->max_y) turtle->max_y = turtle->state.y;
+}
+
+/**
+ * @brief Hands one finished segment to the sink, or appends it to the segment array.
+ *
+ * @param turtle The turtle that drew the segment.
+ * @param segment The segment, as x0, y0, x1, y1.
+ * @param continues Whether the segment starts where the previous one ended.
+ *
+ * @return 1 on success, 0 if allocation fails or the sink stops the turtle.
+ */
+static int emit_segment(Turtle* turtle, const float* segment, int continues) { // output one segment
+    if (turtle->sink) { // hand the segment on instead of storing it
+        return turtle->sink(segment, continues, turtle->sink_context);
+    }
+
+    if (turtle->segment_count == turtle->segment_capacity) {
+        size_t capacity = turtle->segment_capacity ? turtle->segment_capacity * 2 : 4096;
+        float* segments = realloc(turtle->segments, capacity * 4 * sizeof(float));
+
+        if (!segments) {
+            return 0;
+        }
+
+        turtle->segments = segments;
+        turtle->segment_capacity = capacity;
+    }
+
+    memcpy(turtle->segments + turtle->segment_count * 4, segment, 4 * sizeof(float));
+    turtle->segment_count++;
+
+    return 1;
+}
+
+/**
+ * @brief Emits the pending run of collinear draw steps as one segment.
+ *
+ * @param turtle The turtle to flush.
+ *
+ * @return 1 on success, 0 if the segment could not be emitted.
+ */
+static int flush_pending(Turtle* turtle) { // close the current straight run
+    if (!turtle->pending) {
+        return 1;
+    }
+
+    float segment[4] = {(float)turtle->pending_x, (float)turtle->pending_y, (float)turtle->state.x, (float)turtle->state.y};
+    turtle->pending = 0;
+
+    return emit_segment(turtle, segment, turtle->pending_continues);
+}
+
+/**
+ * @brief Prepares a turtle at the origin.
+ *
+ * @param turtle The turtle to initialize.
+ * @param turn_angle The angle, in degrees, turned by '+' and '-'.
+ * @param start_direction The starting heading, in degrees.
+ *
+ * @return 1 on success.
+ */
+int turtle_init(Turtle* turtle, double turn_angle, double start_direction) { // start at the origin
+    memset(turtle, 0, sizeof(*turtle));
+    turtle->turn_angle = turn_angle;
+    turtle->state.direction = start_direction;
+    update_step(turtle);
+
+    return 1;
+}
+
+/**
+ * @brief Interprets a run of symbols, appending to the turtle's segments and bounds.
+ *
+ * The rules are the ones printed by `print_key()` and followed by the Python visualizer:
+ *
+ * - Uppercase letter : move forward one unit while drawing, emitting a segment
+ * - Lowercase letter : move forward one unit without drawing
+ * - '+' / '-' : add / subtract the turn angle from the heading
+ * - '[' / ']' : save / restore the position and heading
+ *
+ * The bounding box starts at the origin and, as in `set_boundaries()`, grows with every
+ * drawn endpoint and every restored position. Any other symbol is ignored. Because all
+ * state lives in the turtle, the parsed string can be fed in chunks, for example straight
+ * from an expansion stream.
+ *
+ * Consecutive draw steps with no state change in between are collinear, so they are
+ * merged into a single segment. The run is held as pending and emitted when a turn, '[',
+ * ']' or lowercase move changes the state, or when `turtle_finish()` is called, which
+ * must happen after the last symbol. `draw_count` still counts every draw step.
+ *
+ * If the turtle has a `sink`, each segment is handed to it instead of being stored, so
+ * memory stays constant. The sink is also told whether the segment continues the previous
+ * one: it does unless a '[', ']' or lowercase move came in between, while turns keep the
+ * line going.
+ *
+ * @param turtle The turtle to advance.
+ * @param symbols The symbols to interpret.
+ * @param count The number of symbols.
+ *
+ * @return 1 on success, 0 if allocation fails.
+ */
+int turtle_feed(Turtle* turtle, const char* symbols, size_t count) { // interpret one run of symbols
+    for (size_t i = 0; i < count; i++) {
+        unsigned char c = (unsigned char)symbols[i];
+
+        if (isupper(c)) { // move forward while drawing, extending the current straight run
+            if (!turtle->pending) {
+                turtle->pending = 1;
+                turtle->pending_x = turtle->state.x;
+                turtle->pending_y = turtle->state.y;
+                turtle->pending_continues = turtle->continues;
+            }
+
+            turtle->state.x += turtle->step_x;
+            turtle->state.y += turtle->step_y;
+            turtle->draw_count++;
+            turtle->continues = 1;
+            include_point(turtle);
+        } else if (islower(c)) { // move forward without drawing
+            if (!flush_pending(turtle)) {
+                return 0;
+            }
+
+            turtle->state.x += turtle->step_x;
+            turtle->state.y += turtle->step_y;
+            turtle->move_count++;
+            turtle->continues = 0;
+        } else if (c == '+' || c == '-') { // a turn ends the straight run but not the line
+            if (!flush_pending(turtle)) {
+                return 0;
+            }
+
+            turtle->state.direction += c == '+' ? turtle->turn_angle : -turtle->turn_angle;
+            update_step(turtle);
+        } else if (c == '[') { // save state to stack
+            if (!flush_pending(turtle)) {
+                return 0;
+            }
+
+            if (turtle->stack_size == turtle->stack_capacity) {
+                size_t capacity = turtle->stack_capacity ? turtle->stack_capacity * 2 : 64;
+                TurtleState* stack = realloc(turtle->stack, capacity * sizeof(TurtleState));
+
+                if (!stack) {
+                    return 0;
+                }
+
+                turtle->stack = stack;
+                turtle->stack_capacity = capacity;
+            }
+
+            turtle->stack[turtle->stack_size++] = turtle->state;
+            turtle->continues = 0;
+        } else if (c == ']') { // restore state from stack, ignored when the stack is empty
+            if (turtle->stack_size > 0) {
+                if (!flush_pending(turtle)) {
+                    return 0;
+                }
+
+                turtle->state = turtle->stack[--turtle->stack_size];
+                update_step(turtle);
+                include_point(turtle);
+                turtle->continues = 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Expansion stream consumer that feeds every chunk to a turtle.
+ *
+ * Pass this to `stream_drain()` with a Turtle as the context to interpret a system
+ * without ever materializing its parsed string.
+ *
+ * @param symbols The symbols to interpret.
+ * @param count The number of symbols.
+ * @param context The Turtle to advance.
+ *
+ * @return 1 on success, 0 if allocation fails, which stops the drain.
+ */
+int turtle_consume(const char* symbols, size_t count, void* context) { // StreamConsumer adapter
+    return turtle_feed((Turtle*)context, symbols, count);
+}
+
+/**
+ * @brief Interprets a whole parsed string in one pass.
+ *
+ * @param turtle The turtle to advance, from `turtle_init()`.
+ * @param parsed The null-terminated parsed string.
+ *
+ * @return 1 on success, 0 if allocation fails.
+ */
+int turtle_interpret(Turtle* turtle, const char* parsed) { // interpret a full parsed string
+    return turtle_feed(turtle, parsed, strlen(parsed)) && turtle_finish(turtle);
+}
+
+/**
+ * @brief Interprets a whole packed string from `parser_packed()`, decoding it on the fly.
+ *
+ * The string is unpacked `TURTLE_DECODE_CHUNK` symbols at a time into a small buffer
+ * that stays in cache, so it is never expanded back to one byte per symbol in memory.
+ * Call `turtle_finish()` once it has been fed.
+ *
+ * @param turtle The turtle to advance, from `turtle_init()`.
+ * @param packed The packed string.
+ *
+ * @return 1 on success, 0 if allocation fails.
+ */
+int turtle_feed_packed(Turtle* turtle, const PackedString* packed) { // decode a chunk, then feed it
+    char chunk[TURTLE_DECODE_CHUNK];
+
+    for (size_t start = 0; start < packed->length; start += TURTLE_DECODE_CHUNK) {
+        size_t count = packed->length - start < TURTLE_DECODE_CHUNK ? packed->length - start : TURTLE_DECODE_CHUNK;
+
+        packed_decode(packed, start, count, chunk);
+        if (!turtle_feed(turtle, chunk, count)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Emits the last pending segment once every symbol has been fed.
+ *
+ * @param turtle The turtle to finish.
+ *
+ * @return 1 on success, 0 if the segment could not be emitted.
+ */
+int turtle_finish(Turtle* turtle) { // flush the final straight run
+    return flush_pending(turtle);
+}
+
+/**
+ * @brief Copies a finished turtle's step counts and bounds.
+ *
+ * @param turtle The finished turtle.
+ * @param segment_count The segments it emitted, which a turtle with a sink does not count itself.
+ * @param totals The totals to fill.
+ */
+void turtle_totals(const Turtle* turtle, size_t segment_count, TurtleTotals* totals) { // report what was drawn
+    totals->draw_count = turtle->draw_count;
+    totals->move_count = turtle->move_count;
+    totals->segment_count = segment_count;
+    totals->bounds.min_x = turtle->min_x;
+    totals->bounds.max_x = turtle->max_x;
+    totals->bounds.min_y = turtle->min_y;
+    totals->bounds.max_y = turtle->max_y;
+}
+
+/**
+ * @brief Releases the segments and stack held by a turtle.
+ *
+ * @param turtle The turtle to free.
+ */
+void turtle_free(Turtle* turtle) { // free segments and state stack
+    free(turtle->segments);
+    free(turtle->stack);
+    turtle->segments = NULL;
+    turtle->stack = NULL;
+    turtle->segment_count = turtle->segment_capacity = 0;
+    turtle->stack_size = turtle->stack_capacity = 0;
+}
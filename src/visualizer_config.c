@@ -1,4 +1,7 @@
 #include "visualizer_config.h"
+#include "turtle.h"
+#include "tiles.h"
+#include "trace.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -6,6 +9,100 @@
 #include <string.h>
 #include <Python.h>
 
+static TilePyramid* active_tiles = NULL; // the pyramid being viewed, served to Python by `lsystem_tiles.tile()`
+
+/**
+ * @brief Python function `lsystem_tiles.tile(level, x, y)`, which returns one tile's RGBA pixels.
+ *
+ * The pixels are copied into a bytes object, because the pyramid may evict the tile
+ * while Python still holds it.
+ */
+static PyObject* get_tile(PyObject* self, PyObject* args) { // serve one tile to the visualizer
+    (void)self;
+    int level, x, y;
+    if (!PyArg_ParseTuple(args, "iii", &level, &x, &y)) {
+        return NULL;
+    }
+
+    const Framebuffer* tile = active_tiles ? tile_pyramid_get(active_tiles, level, x, y) : NULL;
+    if (!tile) {
+        PyErr_SetString(PyExc_ValueError, "no such tile");
+        return NULL;
+    }
+
+    return PyBytes_FromStringAndSize((const char*)tile->pixels, (Py_ssize_t)tile->width * tile->height * 4);
+}
+
+static PyMethodDef tile_methods[] = {
+    {"tile", get_tile, METH_VARARGS, "Returns the RGBA pixels of one tile of the pyramid being viewed."},
+    {NULL, NULL, 0, NULL}
+};
+
+static struct PyModuleDef tile_module = {
+    PyModuleDef_HEAD_INIT, "lsystem_tiles", "Level-of-detail tiles rasterized by the C side.", -1, tile_methods, NULL, NULL, NULL, NULL
+};
+
+/**
+ * @brief Creates the built-in `lsystem_tiles` module when Python first imports it.
+ */
+static PyObject* init_tile_module(void) { // module init for PyImport_AppendInittab
+    return PyModule_Create(&tile_module);
+}
+
+/**
+ * @brief Python function `lsystem_trace.enabled()`, which reports whether a trace is being recorded.
+ */
+static PyObject* trace_is_enabled(PyObject* self, PyObject* args) { // let Python skip its spans when tracing is off
+    (void)self;
+    (void)args;
+    return PyBool_FromLong(trace_enabled);
+}
+
+/**
+ * @brief Python function `lsystem_trace.now()`, which returns the trace clock, to start a span.
+ */
+static PyObject* trace_now(PyObject* self, PyObject* args) { // same clock as the C spans
+    (void)self;
+    (void)args;
+    return PyFloat_FromDouble(trace_clock());
+}
+
+/**
+ * @brief Python function `lsystem_trace.span(name, start, arg_name=None, arg_value=0)`, which ends a span.
+ */
+static PyObject* trace_span(PyObject* self, PyObject* args) { // record a span measured in Python
+    (void)self;
+    const char* name;
+    double start;
+    const char* arg_name = NULL;
+    double arg_value = 0;
+
+    if (!PyArg_ParseTuple(args, "sd|zd", &name, &start, &arg_name, &arg_value)) {
+        return NULL;
+    }
+
+    trace_end(name, start, arg_name, arg_value);
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef trace_methods[] = {
+    {"enabled", trace_is_enabled, METH_NOARGS, "Returns whether a trace is being recorded."},
+    {"now", trace_now, METH_NOARGS, "Returns the trace clock, in microseconds."},
+    {"span", trace_span, METH_VARARGS, "Records a span from a start time to now, with an optional numeric argument."},
+    {NULL, NULL, 0, NULL}
+};
+
+static struct PyModuleDef trace_module = {
+    PyModuleDef_HEAD_INIT, "lsystem_trace", "Tracing spans recorded into the C program's trace.", -1, trace_methods, NULL, NULL, NULL, NULL
+};
+
+/**
+ * @brief Creates the built-in `lsystem_trace` module when Python first imports it.
+ */
+static PyObject* init_trace_module(void) { // module init for PyImport_AppendInittab
+    return PyModule_Create(&trace_module);
+}
+
 /**
  * @brief Initialize the Python environment once, at the very start of program.
  * 
@@ -15,9 +112,16 @@
  * 
  * The function is implemented such that it will not crash if the Python environment
  * has already been setup. It is still recommended to call this function only once,
- * at the very start of program.
+ * at the very start of program. The built-in `lsystem_tiles` and `lsystem_trace` modules
+ * are registered first, so the visualizer can fetch tiles from `visualize()` and record
+ * its own spans into the trace.
  */
 void initialize_python() { // setup Python environment once, at the very start of program
+    double span = trace_begin();
+    if (!Py_IsInitialized()) {
+        PyImport_AppendInittab("lsystem_tiles", init_tile_module); // must happen before Py_Initialize
+        PyImport_AppendInittab("lsystem_trace", init_trace_module);
+    }
     Py_Initialize();
     PyObject *sys_module = PyImport_ImportModule("sys");
     PyObject *sys_path = PyObject_GetAttrString(sys_module, "path"); // get sys.path
@@ -42,6 +146,7 @@ void initialize_python() { // setup Python environment once, at the very start o
         "        time.sleep(0.5)\n"
         "        self.app.quit()\n"
     );
+    trace_end("python_startup", span, NULL, 0);
 }
 
 /**
@@ -68,11 +173,22 @@ void finalize_python() { // finalize Python environment once, at the very end of
  * to visualize the L-System. The function also creates a `QApplication` instance
  * and starts the event loop to run the visualization.
  * 
+ * The parsed string is not copied into a Python str. Python receives a read-only
+ * memoryview over the C buffer, so the caller must keep `parsed` alive until this
+ * function returns. The memoryview is released before returning, so any Python object
+ * that outlives the visualization gets a ValueError instead of a dangling pointer.
+ * 
+ * A parsed string of at least `TILE_MIN_SYMBOLS` symbols is interpreted here by the C
+ * turtle and turned into a tile pyramid. The visualizer then shows it as tiles, drawing
+ * only the ones in view at the current zoom, instead of animating every segment.
+ * 
  * @param parsed The parsed string of the L-System.
  * @param turn_angle The angle at which to turn left or right.
  * @param start_direction The starting direction of the visualization.
+ * @param bounds The drawing bounds from `calculate_bounds()`, which saves the visualizer a
+ * full walk of the string in `set_boundaries()`, or NULL to let the visualizer find them.
  */
-void visualize(const char* parsed, double turn_angle, double start_direction) { // visualize an L-System
+void visualize(const char* parsed, double turn_angle, double start_direction, const Bounds* bounds) { // visualize an L-System
     PyObject *pModule = PyImport_ImportModule("visualizer"); // find visualizer.py
     if (!pModule) {
         PyErr_Print();
@@ -86,23 +202,90 @@ void visualize(const char* parsed, double turn_angle, double start_direction) {
         return;
     }
 
-    PyObject *pArgs = PyTuple_Pack(3, // pack argumetnts to pass to LSystemVisualizer
-        PyUnicode_FromString(parsed),
-        PyFloat_FromDouble(turn_angle),
-        PyFloat_FromDouble(start_direction)
-    );
+    Turtle turtle;
+    TilePyramid tiles;
+    int has_tiles = 0;
+    Bounds drawn;
+
+    if (strlen(parsed) >= TILE_MIN_SYMBOLS) { // too large to animate, build level-of-detail tiles instead
+        double span = trace_begin();
+        turtle_init(&turtle, turn_angle, start_direction);
+
+        if (turtle_interpret(&turtle, parsed)) {
+            drawn.min_x = turtle.min_x;
+            drawn.max_x = turtle.max_x;
+            drawn.min_y = turtle.min_y;
+            drawn.max_y = turtle.max_y;
+            has_tiles = tile_pyramid_build(&tiles, turtle.segments, turtle.segment_count, &drawn);
+
+            if (!bounds) {
+                bounds = &drawn; // the turtle already walked the string
+            }
+        }
+
+        if (!has_tiles) {
+            turtle_free(&turtle);
+        }
+        trace_end("tile_pyramid_build", span, "segments", has_tiles ? (double)turtle.segment_count : 0);
+    }
+
+    double span = trace_begin();
 
+    PyObject *pParsed = PyMemoryView_FromMemory((char*)parsed, (Py_ssize_t)strlen(parsed), PyBUF_READ); // zero-copy view of the parsed string
+    PyObject *pTurn = PyFloat_FromDouble(turn_angle);
+    PyObject *pStart = PyFloat_FromDouble(start_direction);
+    if (!pParsed || !pTurn || !pStart) {
+        PyErr_Print();
+        Py_XDECREF(pParsed);
+        Py_XDECREF(pTurn);
+        Py_XDECREF(pStart);
+        Py_DECREF(pModule);
+        Py_DECREF(pClass);
+        if (has_tiles) {
+            tile_pyramid_free(&tiles);
+            turtle_free(&turtle);
+        }
+        return;
+    }
+
+    PyObject *pBounds = bounds // (min_x, max_x, min_y, max_y), or None for the visualizer to walk the string itself
+        ? Py_BuildValue("(dddd)", bounds->min_x, bounds->max_x, bounds->min_y, bounds->max_y)
+        : (Py_INCREF(Py_None), Py_None);
+
+    PyObject *pTiles = has_tiles // (origin_x, origin_y, world_size, levels, tile_size), or None to animate the segments
+        ? Py_BuildValue("(dddii)", tiles.origin_x, tiles.origin_y, tiles.world_size, tiles.levels, TILE_SIZE)
+        : (Py_INCREF(Py_None), Py_None);
+    active_tiles = has_tiles ? &tiles : NULL;
+
+    PyObject *pArgs = PyTuple_Pack(5, pParsed, pTurn, pStart, pBounds, pTiles); // pack argumetnts to pass to LSystemVisualizer
+    Py_DECREF(pTurn);
+    Py_DECREF(pStart);
+    Py_XDECREF(pBounds);
+    Py_XDECREF(pTiles); // the tuple holds its own references
+
+    trace_end("python_handoff", span, "bytes", (double)strlen(parsed));
+
+    span = trace_begin();
     PyObject *pInstance = PyObject_CallObject(pClass, pArgs); // call the object with the arguments
+    trace_end("visualizer_init", span, NULL, 0);
     if (!pInstance) {
         PyErr_Print();
+        PyObject_CallMethod(pParsed, "release", NULL);
+        Py_DECREF(pParsed);
         Py_DECREF(pModule);
         Py_DECREF(pClass);
         Py_DECREF(pArgs);
+        if (has_tiles) {
+            active_tiles = NULL;
+            tile_pyramid_free(&tiles);
+            turtle_free(&turtle);
+        }
         return;
     }
 
     PyObject *pMethod = PyObject_GetAttrString(pInstance, "visualize"); // get the visualize method of the LSystemVisualizer object
     if (pMethod) {
+        span = trace_begin();
         PyObject_CallObject(pMethod, NULL);
         Py_DECREF(pMethod);
         
@@ -113,6 +296,7 @@ void visualize(const char* parsed, double turn_angle, double start_direction) {
             "    timer.start()\n"
             "    app.exec_()\n"
         );
+        trace_end("qt_event_loop", span, NULL, 0);
     } else {
         PyErr_Print();
     }
@@ -121,4 +305,17 @@ void visualize(const char* parsed, double turn_angle, double start_direction) {
     Py_DECREF(pClass);
     Py_DECREF(pArgs);
     Py_DECREF(pInstance); // clean up memory after each visualization
+
+    PyObject *pReleased = PyObject_CallMethod(pParsed, "release", NULL); // the C buffer may be freed after this returns
+    if (!pReleased) {
+        PyErr_Print();
+    }
+    Py_XDECREF(pReleased);
+    Py_DECREF(pParsed);
+
+    if (has_tiles) { // later calls to lsystem_tiles.tile() raise instead of touching freed tiles
+        active_tiles = NULL;
+        tile_pyramid_free(&tiles);
+        turtle_free(&turtle);
+    }
 }
\ No newline at end of file